@@ -16,38 +16,102 @@
 
 #include "ColorCane.hpp"
 
+#include <cstddef>
+
+#include <array>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <boost/utility/string_ref.hpp>
+
+// Characters repeated at most this many times are taken from static storage.
+static const int maxRun = 128;
+
+static boost::string_ref getRun(char c, int count);
+
 void
 ColorCane::append(boost::string_ref text, const Node *node, ColorGroup hi)
 {
-    if (canAppend(node, hi)) {
-        pieces.back().text.append(text.begin(), text.end());
-    } else {
-        pieces.emplace_back(text.to_string(), node, hi);
-    }
+    add(text, node, hi, {});
+}
+
+void
+ColorCane::append(std::string text, const Node *node, ColorGroup hi)
+{
+    // Storage isn't const to allow growing it in place in `add()`.
+    std::shared_ptr<const std::string> storage =
+        std::make_shared<std::string>(std::move(text));
+    add(*storage, node, hi, storage);
+}
+
+void
+ColorCane::append(const ColorCanePiece &piece)
+{
+    add(piece.text, piece.node, piece.hi, piece.storage);
 }
 
 void
 ColorCane::append(char text, ColorGroup hi, const Node *node)
 {
-    if (canAppend(node, hi)) {
-        pieces.back().text.append(1, text);
-    } else {
-        pieces.emplace_back(std::string(1, text), node, hi);
-    }
+    add(getRun(text, 1), node, hi, {});
 }
 
 void
 ColorCane::append(char text, int count, ColorGroup hi, const Node *node)
 {
-    if (canAppend(node, hi)) {
-        pieces.back().text.append(count, text);
+    if (count <= maxRun) {
+        add(getRun(text, count), node, hi, {});
     } else {
-        pieces.emplace_back(std::string(count, text), node, hi);
+        append(std::string(count, text), node, hi);
+    }
+}
+
+void
+ColorCane::add(boost::string_ref text, const Node *node, ColorGroup hi,
+               const std::shared_ptr<const std::string> &storage)
+{
+    if (!canAppend(node, hi)) {
+        pieces.emplace_back(text, node, hi, storage);
+        return;
+    }
+
+    ColorCanePiece &last = pieces.back();
+    if (text.empty()) {
+        return;
+    }
+    if (last.text.empty()) {
+        last.text = text;
+        last.storage = storage;
+        return;
+    }
+
+    // Adjacent views are extended, otherwise texts are concatenated.
+    if (last.storage == storage &&
+        last.text.data() + last.text.size() == text.data()) {
+        last.text = boost::string_ref(last.text.data(),
+                                      last.text.size() + text.size());
+        return;
     }
+
+    // Storage owned only by the last piece is extended to avoid copying all
+    // accumulated text on every append.
+    if (last.storage != nullptr && last.storage.use_count() == 1 &&
+        last.text.end() == last.storage->data() + last.storage->size()) {
+        auto &owned = const_cast<std::string &>(*last.storage);
+        const std::size_t offset = last.text.data() - owned.data();
+        owned.append(text.begin(), text.end());
+        last.text = boost::string_ref(owned.data() + offset,
+                                      owned.size() - offset);
+        return;
+    }
+
+    auto merged = std::make_shared<std::string>(last.text.begin(),
+                                                last.text.end());
+    merged->append(text.begin(), text.end());
+    last.text = *merged;
+    last.storage = std::move(merged);
 }
 
 bool
@@ -74,21 +138,21 @@ std::vector<ColorCane>
 ColorCane::splitIntoLines() &&
 {
     std::vector<ColorCane> split(1);
-    for (ColorCanePiece &piece : pieces) {
-        std::string &text = piece.text;
+    for (const ColorCanePiece &piece : pieces) {
+        boost::string_ref text = piece.text;
 
         while (!text.empty()) {
             auto pos = text.find('\n');
-            if (pos == std::string::npos) {
-                split.back().append(std::move(text), piece.node, piece.hi);
+            if (pos == boost::string_ref::npos) {
+                split.back().add(text, piece.node, piece.hi, piece.storage);
                 break;
             }
 
             if (pos != 0U) {
-                split.back().append(std::string(text, 0, pos), piece.node,
-                                    piece.hi);
+                split.back().add(text.substr(0, pos), piece.node, piece.hi,
+                                 piece.storage);
             }
-            text.erase(0, pos + 1);
+            text.remove_prefix(pos + 1);
             split.emplace_back();
         }
     }
@@ -99,28 +163,27 @@ std::vector<ColorCane>
 ColorCane::breakAt(boost::string_ref separators) &&
 {
     std::vector<ColorCane> split(1);
-    for (ColorCanePiece &piece : pieces) {
-        std::string &text = piece.text;
+    for (const ColorCanePiece &piece : pieces) {
+        boost::string_ref text = piece.text;
 
         if (split.size() == 2U) {
-            split.back().append(std::move(text), piece.node, piece.hi);
+            split.back().add(text, piece.node, piece.hi, piece.storage);
             continue;
         }
 
-        auto pos = text.find_first_not_of(separators.data(), 0U,
-                                          separators.size());
-        if (pos == std::string::npos) {
-            split.back().append(std::move(text), piece.node, piece.hi);
+        auto pos = text.find_first_not_of(separators);
+        if (pos == boost::string_ref::npos) {
+            split.back().add(text, piece.node, piece.hi, piece.storage);
             continue;
         }
 
         if (pos != 0U) {
-            split.back().append(std::string(text, 0, pos), piece.node,
-                                piece.hi);
+            split.back().add(text.substr(0, pos), piece.node, piece.hi,
+                             piece.storage);
         }
-        text.erase(0, pos);
+        text.remove_prefix(pos);
         split.emplace_back();
-        split.back().append(std::move(text), piece.node, piece.hi);
+        split.back().add(text, piece.node, piece.hi, piece.storage);
     }
 
     if (split.size() == 1U) {
@@ -129,3 +192,19 @@ ColorCane::breakAt(boost::string_ref separators) &&
 
     return split;
 }
+
+// Retrieves statically allocated string of `count` characters `c`.
+static boost::string_ref
+getRun(char c, int count)
+{
+    static const std::array<std::string, 256> runs = []() {
+        std::array<std::string, 256> runs;
+        for (int i = 0; i < 256; ++i) {
+            runs[i].assign(maxRun, static_cast<char>(i));
+        }
+        return runs;
+    }();
+
+    return boost::string_ref(runs[static_cast<unsigned char>(c)].data(),
+                             count);
+}
@@ -19,6 +19,7 @@
 
 #include <boost/utility/string_ref.hpp>
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,27 +28,36 @@ enum class ColorGroup;
 
 class Node;
 
-// Single item of `ColorCane`.
+// Single item of `ColorCane`.  Text is a view, which refers either to storage
+// of a tree or to `storage`.
 struct ColorCanePiece
 {
-    ColorCanePiece(std::string text, const Node *node, ColorGroup hi)
-        : text(std::move(text)), node(node), hi(hi)
+    ColorCanePiece(boost::string_ref text, const Node *node, ColorGroup hi,
+                   std::shared_ptr<const std::string> storage = {})
+        : text(text), node(node), hi(hi), storage(std::move(storage))
     { }
 
-    std::string text; // Text of the item (can be empty).
-    const Node *node; // Node associated with the text (can be `nullptr`).
-    ColorGroup hi;    // Highlighting of the piece.
+    boost::string_ref text; // Text of the item (can be empty).
+    const Node *node;       // Node associated with the text (can be `nullptr`).
+    ColorGroup hi;          // Highlighting of the piece.
+    // Owner of synthesized text or `nullptr`.
+    std::shared_ptr<const std::string> storage;
 };
 
 // Allows constructing string consisting of multiple pieces each of which is
-// associated with some metadata.
+// associated with some metadata.  Pieces don't copy text, which is either
+// owned by a tree or synthesized.
 class ColorCane
 {
     using Pieces = std::vector<ColorCanePiece>;
 
 public:
-    // Appends a string.
+    // Appends a string that outlives the cane.
     void append(boost::string_ref text, const Node *node, ColorGroup hi = {});
+    // Appends a synthesized string.
+    void append(std::string text, const Node *node, ColorGroup hi = {});
+    // Appends a piece of another cane.
+    void append(const ColorCanePiece &piece);
     // Appends single character.
     void append(char text, ColorGroup hi = {}, const Node *node = nullptr);
     // Appends single character that's repeated `count` times.
@@ -66,6 +76,9 @@ public:
     std::vector<ColorCane> breakAt(boost::string_ref separators) &&;
 
 private:
+    // Appends text merging it with the last piece if possible.
+    void add(boost::string_ref text, const Node *node, ColorGroup hi,
+             const std::shared_ptr<const std::string> &storage);
     // Checks whether can append to the last piece instead of creating new one.
     bool canAppend(const Node *node, ColorGroup hi) const;
 
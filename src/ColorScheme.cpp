@@ -16,8 +16,10 @@
 
 #include "ColorScheme.hpp"
 
-// TODO: colors should reside in some configuration file, it's very inconvenient
-//       to have to recompile the tool to experiment with coloring.
+#include <cstddef>
+
+#include <array>
+#include <utility>
 
 static inline std::size_t
 operator+(ColorGroup cg)
@@ -25,52 +27,115 @@ operator+(ColorGroup cg)
     return static_cast<std::size_t>(cg);
 }
 
-ColorScheme::ColorScheme()
+// TODO: colors should reside in some configuration file, it's very inconvenient
+//       to have to recompile the tool to experiment with coloring.
+
+// Number of color groups.
+static constexpr std::size_t nGroups =
+    static_cast<std::size_t>(ColorGroup::ColorGroupCount);
+
+// Builds table of appearances of all color groups.
+static std::array<ColorSpec, nGroups>
+makeSpecs()
+{
+    std::array<ColorSpec, nGroups> specs;
+    specs.fill({ -1, -1, false, false, nullptr, nullptr });
+
+    specs[+ColorGroup::LineNo] = { 0, 7, false, false, nullptr, nullptr };
+
+    specs[+ColorGroup::Path] = { 3, -1, false, false, nullptr, nullptr };
+    specs[+ColorGroup::LineNoPart] = { 6, -1, false, false, nullptr, nullptr };
+    specs[+ColorGroup::ColNoPart] = { 6, -1, false, false, nullptr, nullptr };
+
+    specs[+ColorGroup::PieceDeleted] = { 124, 7, true, true, "{-", "-}" };
+    specs[+ColorGroup::PieceInserted] = { 83, 0, true, true, "{+", "+}" };
+    specs[+ColorGroup::PieceUpdated] = { 232, 212, true, false, "{~", "~}" };
+    specs[+ColorGroup::UpdatedSurroundings] = { 232, 213, true, false,
+                                                nullptr, nullptr };
+
+    specs[+ColorGroup::Deleted] = { 210, 0, true, true, "{-", "-}" };
+    specs[+ColorGroup::Inserted] = { 85, 0, true, true, "{+", "+}" };
+    specs[+ColorGroup::Updated] = { 228, 0, true, true, "{#", "#}" };
+    specs[+ColorGroup::Moved] = { 81, -1, true, true, "{:", ":}" };
+
+    const std::pair<ColorGroup, int> syntax[] = {
+        { ColorGroup::Specifiers, 183 },
+        { ColorGroup::UserTypes,  215 },
+        { ColorGroup::Types,      85 },
+        { ColorGroup::Directives, 228 },
+        { ColorGroup::Comments,   248 },
+        { ColorGroup::Functions,  81 },
+        { ColorGroup::Keywords,   115 },
+        { ColorGroup::Brackets,   222 },
+        { ColorGroup::Operators,  224 },
+        { ColorGroup::Constants,  219 },
+    };
+    for (const auto &entry : syntax) {
+        specs[+entry.first].fg = entry.second;
+    }
+
+    return specs;
+}
+
+const ColorSpec &
+getColorSpec(ColorGroup colorGroup)
+{
+    static const std::array<ColorSpec, nGroups> specs = makeSpecs();
+    return specs[+colorGroup];
+}
+
+// Appends attribute to a decoration.
+static void
+add(decor::Decoration &dec, const decor::Decoration &attr)
+{
+    dec = (dec.isEmpty() ? attr : dec + attr);
+}
+
+// Converts appearance of a color group into a decoration.
+static decor::Decoration
+makeDecoration(const ColorSpec &spec)
 {
     using namespace decor;
     using namespace decor::literals;
 
-    groups[+ColorGroup::LineNo] = decor::white_bg + decor::black_fg;
-
-    groups[+ColorGroup::Path] = decor::yellow_fg;
-    groups[+ColorGroup::LineNoPart] = decor::cyan_fg;
-    groups[+ColorGroup::ColNoPart] = decor::cyan_fg;
-
-    groups[+ColorGroup::PieceDeleted] = (124_fg + white_bg + bold + inv)
-                                        .prefix("{-"_lit)
-                                        .suffix("-}"_lit);
-    groups[+ColorGroup::PieceInserted] = (83_fg + inv + black_bg + bold)
-                                         .prefix("{+"_lit)
-                                         .suffix("+}"_lit);
-    groups[+ColorGroup::PieceUpdated] = Decoration(212_bg + 232_fg + bold)
-                                        .prefix("{~"_lit)
-                                        .suffix("~}"_lit);
-    groups[+ColorGroup::UpdatedSurroundings] = (213_bg + 232_fg + bold);
-
-    groups[+ColorGroup::Deleted] = groups[+ColorGroup::PieceDeleted];
-    groups[+ColorGroup::Inserted] = groups[+ColorGroup::PieceInserted];
-    groups[+ColorGroup::Deleted] = (210_fg + inv + black_bg + bold)
-                                   .prefix("{-"_lit)
-                                   .suffix("-}"_lit);
-    groups[+ColorGroup::Inserted] = (85_fg + inv + black_bg + bold)
-                                    .prefix("{+"_lit)
-                                    .suffix("+}"_lit);
-    groups[+ColorGroup::Updated] = (228_fg + inv + black_bg + bold);
-    groups[+ColorGroup::Updated].prefix("{#"_lit).suffix("#}"_lit);
-    groups[+ColorGroup::Moved] = (81_fg + inv + bold)
-                                 .prefix("{:"_lit)
-                                 .suffix(":}"_lit);
-
-    groups[+ColorGroup::Specifiers] = 183_fg;
-    groups[+ColorGroup::UserTypes] = 215_fg;
-    groups[+ColorGroup::Types] = 85_fg;
-    groups[+ColorGroup::Directives] = 228_fg;
-    groups[+ColorGroup::Comments] = 248_fg;
-    groups[+ColorGroup::Functions] = 81_fg;
-    groups[+ColorGroup::Keywords] = 115_fg;
-    groups[+ColorGroup::Brackets] = 222_fg;
-    groups[+ColorGroup::Operators] = 224_fg;
-    groups[+ColorGroup::Constants] = 219_fg;
+    // Standard colors are output as such instead of as indexes in a palette.
+    static const Decoration *const stdFg[] = {
+        &black_fg, &red_fg, &green_fg, &yellow_fg,
+        &blue_fg, &magenta_fg, &cyan_fg, &white_fg
+    };
+    static const Decoration *const stdBg[] = {
+        &black_bg, &red_bg, &green_bg, &yellow_bg,
+        &blue_bg, &magenta_bg, &cyan_bg, &white_bg
+    };
+
+    Decoration dec;
+    if (spec.fg >= 0) {
+        add(dec, spec.fg < 8 ? *stdFg[spec.fg] : Decoration(&fg256, spec.fg));
+    }
+    if (spec.bg >= 0) {
+        add(dec, spec.bg < 8 ? *stdBg[spec.bg] : Decoration(&bg256, spec.bg));
+    }
+    if (spec.bold) {
+        add(dec, bold);
+    }
+    if (spec.inverse) {
+        add(dec, inv);
+    }
+    if (spec.prefix != nullptr) {
+        dec.prefix(Decoration(&lit, spec.prefix));
+    }
+    if (spec.suffix != nullptr) {
+        dec.suffix(Decoration(&lit, spec.suffix));
+    }
+    return dec;
+}
+
+ColorScheme::ColorScheme()
+{
+    for (std::size_t i = 0U; i < size; ++i) {
+        groups[i] = makeDecoration(getColorSpec(static_cast<ColorGroup>(i)));
+        sequences[i] = decor::precompile(groups[i]);
+    }
 }
 
 const decor::Decoration &
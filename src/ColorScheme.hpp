@@ -18,21 +18,61 @@
 #define ZOGRASCOPE__COLORSCHEME_HPP__
 
 #include <array>
+#include <string>
+#include <utility>
+
+#include <boost/utility/string_ref.hpp>
 
 #include "colors.hpp"
 #include "decoration.hpp"
 
+// Appearance of a color group that doesn't depend on the way it's displayed.
+// Colors are indexes into 256-color palette with first eight being standard
+// terminal colors, negative value stands for default color.
+struct ColorSpec
+{
+    int fg;             // Foreground color.
+    int bg;             // Background color.
+    bool bold;          // Whether text is bold.
+    bool inverse;       // Whether foreground and background are swapped.
+    const char *prefix; // Marker printed before text if colors are disabled.
+    const char *suffix; // Marker printed after text if colors are disabled.
+};
+
+// Retrieves appearance of the color group.  This is the single source of
+// colors for all color schemes of terminal.
+const ColorSpec & getColorSpec(ColorGroup colorGroup);
+
 class ColorScheme
 {
+    // Number of color groups.
+    static constexpr std::size_t size =
+        static_cast<std::size_t>(ColorGroup::ColorGroupCount);
+
 public:
+    // Sequences that surround highlighted text are precompiled according to
+    // state of decorations at the moment of construction.
     ColorScheme();
 
 public:
     const decor::Decoration & operator[](ColorGroup colorGroup) const;
 
+    // Appends text highlighted as the color group to the buffer.  This is the
+    // same as printing `cs[colorGroup] << text`, but faster.
+    void print(std::string &buf, ColorGroup colorGroup,
+               boost::string_ref text) const
+    {
+        const std::pair<std::string, std::string> &seqs =
+            sequences[static_cast<std::size_t>(colorGroup)];
+        buf += seqs.first;
+        buf.append(text.data(), text.size());
+        buf += seqs.second;
+    }
+
 private:
-    std::array<decor::Decoration,
-               static_cast<std::size_t>(ColorGroup::ColorGroupCount)> groups;
+    std::array<decor::Decoration, size> groups;
+    // Opening and closing sequences of every group.
+    std::array<std::pair<std::string, std::string>, size> sequences;
 };
 
 #endif // ZOGRASCOPE__COLORSCHEME_HPP__
@@ -0,0 +1,377 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "EditScript.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LexerData.hpp"
+#include "tree.hpp"
+
+// Output is written in blocks of about this size.
+static const std::size_t outputBlockSize = 64*1024;
+
+namespace {
+
+// Leaf of a tree as it's displayed.
+struct Token
+{
+    const Node *node; // Leaf node.
+    State state;      // State of the leaf or of the node that contains it.
+    bool moved;       // Whether the leaf or the node containing it was moved.
+};
+
+// Extent of a token in contents of a file.
+struct Span
+{
+    std::size_t offset;    // Offset of the first byte.
+    std::size_t endOffset; // Offset past the last byte.
+    int endLine;           // Line of the last character.
+    int endCol;            // Column past the last character.
+};
+
+// Maps positions of tokens onto contents of a file.  Locating tokens in the
+// order they appear in the file avoids rescanning lines.
+class Locator
+{
+public:
+    // The reference must be valid while the object exists.
+    explicit Locator(const std::string &contents);
+
+public:
+    // Computes extent of the token.
+    Span locate(const Node &node);
+
+private:
+    // Moves current position by one character, which is one byte or a
+    // two-byte line break.  Returns number of characters of spelling that
+    // correspond to it.
+    int advance();
+    // Retrieves length of line break at specified offset or zero if there is
+    // none.  Line breaks are the same as in lexers: "\n", "\r" and "\r\n".
+    int newlineLength(std::size_t at) const;
+
+private:
+    const std::string &contents;          // Contents of the file.
+    std::vector<std::size_t> lineOffsets; // Offsets of starts of lines.
+    std::size_t offset = 0U;              // Current offset.
+    int line = 1;                         // Current line.
+    int col = 1;                          // Current column.
+};
+
+// Collects tokens of a tree and serializes them.
+class Writer
+{
+public:
+    Writer(const Node &left, const std::string &leftContents,
+           const Node &right, const std::string &rightContents,
+           EditScriptFormat format, std::ostream &os);
+
+public:
+    // Writes out the whole script.
+    void write();
+
+private:
+    // Collects leaves of a tree propagating states of layers.
+    void collect(const Node &node, State state, bool moved,
+                 std::vector<Token> &tokens);
+    // Writes tokens of one side.
+    void writeSide(const char name[], const std::vector<Token> &tokens,
+                   const std::unordered_map<const Node *, int> &others,
+                   const std::string &contents);
+    // Appends a number in LEB128 format.
+    void writeNum(std::uint64_t n);
+    // Writes out buffered output if there is enough of it.
+    void flushIfFull();
+
+private:
+    const EditScriptFormat format;     // Output format.
+    std::ostream &os;                  // Output stream.
+    const std::string &lContents;      // Contents of the left file.
+    const std::string &rContents;      // Contents of the right file.
+    std::vector<Token> lTokens;        // Tokens of the left tree.
+    std::vector<Token> rTokens;        // Tokens of the right tree.
+    std::string buffer;                // Output that wasn't written yet.
+};
+
+}
+
+static std::unordered_map<const Node *, int>
+indexTokens(const std::vector<Token> &tokens);
+static const char * toString(State state);
+
+void
+writeEditScript(const Node &left, const std::string &leftContents,
+                const Node &right, const std::string &rightContents,
+                EditScriptFormat format, std::ostream &os)
+{
+    Writer(left, leftContents, right, rightContents, format, os).write();
+}
+
+Locator::Locator(const std::string &contents) : contents(contents)
+{
+    lineOffsets.push_back(0U);
+    for (std::size_t i = 0U; i < contents.size(); ++i) {
+        if (const int len = newlineLength(i)) {
+            i += len - 1;
+            lineOffsets.push_back(i + 1U);
+        }
+    }
+}
+
+Span
+Locator::locate(const Node &node)
+{
+    // Restart from the beginning of the line unless the token is further on
+    // the current one.
+    if (node.line != line || node.col < col) {
+        if (node.line < 1 ||
+            node.line > static_cast<int>(lineOffsets.size())) {
+            return { contents.size(), contents.size(), node.line, node.col };
+        }
+        offset = lineOffsets[node.line - 1];
+        line = node.line;
+        col = 1;
+    }
+
+    while (col < node.col && offset < contents.size() &&
+           newlineLength(offset) == 0) {
+        advance();
+    }
+
+    Span span;
+    span.offset = offset;
+
+    // Spelling has tabulations replaced with spaces, so it's consumed by
+    // columns rather than by bytes.
+    int width = node.spelling.size();
+    while (width > 0 && offset < contents.size()) {
+        width -= advance();
+    }
+
+    span.endOffset = offset;
+    span.endLine = line;
+    span.endCol = col;
+    return span;
+}
+
+int
+Locator::advance()
+{
+    if (const int len = newlineLength(offset)) {
+        offset += len;
+        ++line;
+        col = 1;
+        return len;
+    }
+
+    if (contents[offset++] == '\t') {
+        const int width = LexerData::tabWidth - (col - 1)%LexerData::tabWidth;
+        col += width;
+        return width;
+    }
+
+    ++col;
+    return 1;
+}
+
+int
+Locator::newlineLength(std::size_t at) const
+{
+    if (contents[at] == '\n') {
+        return 1;
+    }
+    if (contents[at] == '\r') {
+        return (at + 1U < contents.size() && contents[at + 1U] == '\n')
+             ? 2
+             : 1;
+    }
+    return 0;
+}
+
+Writer::Writer(const Node &left, const std::string &leftContents,
+               const Node &right, const std::string &rightContents,
+               EditScriptFormat format, std::ostream &os)
+    : format(format), os(os), lContents(leftContents), rContents(rightContents)
+{
+    collect(left, State::Unchanged, false, lTokens);
+    collect(right, State::Unchanged, false, rTokens);
+    buffer.reserve(outputBlockSize);
+}
+
+void
+Writer::write()
+{
+    if (format == EditScriptFormat::Json) {
+        buffer += "{";
+        writeSide("old", lTokens, indexTokens(rTokens), lContents);
+        buffer += ",";
+        writeSide("new", rTokens, indexTokens(lTokens), rContents);
+        buffer += "}\n";
+    } else {
+        buffer += "ZSES";
+        buffer += '\1';
+        writeSide("old", lTokens, indexTokens(rTokens), lContents);
+        writeSide("new", rTokens, indexTokens(lTokens), rContents);
+    }
+
+    os.write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void
+Writer::collect(const Node &node, State state, bool moved,
+                std::vector<Token> &tokens)
+{
+    // State of the outermost changed layer or leaf wins.
+    if (node.next != nullptr || node.leaf) {
+        if (state == State::Unchanged) {
+            state = node.state;
+        }
+        moved |= node.moved;
+    }
+
+    if (node.next != nullptr) {
+        return collect(*node.next, state, moved, tokens);
+    }
+
+    if (node.leaf) {
+        tokens.push_back({ &node, state, moved });
+        return;
+    }
+
+    for (const Node *child : node.children) {
+        collect(*child, state, moved, tokens);
+    }
+}
+
+void
+Writer::writeSide(const char name[], const std::vector<Token> &tokens,
+                  const std::unordered_map<const Node *, int> &others,
+                  const std::string &contents)
+{
+    const bool json = (format == EditScriptFormat::Json);
+
+    if (json) {
+        buffer += '"';
+        buffer += name;
+        buffer += "\":[";
+    } else {
+        writeNum(tokens.size());
+    }
+
+    Locator locator(contents);
+
+    bool first = true;
+    for (const Token &token : tokens) {
+        const Node &node = *token.node;
+
+        const Span span = locator.locate(node);
+
+        int relative = -1;
+        if (node.relative != nullptr) {
+            auto it = others.find(node.relative);
+            if (it != others.end()) {
+                relative = it->second;
+            }
+        }
+
+        if (!json) {
+            writeNum(node.line);
+            writeNum(node.col);
+            writeNum(span.endLine - node.line);
+            writeNum(span.endCol);
+            writeNum(span.offset);
+            writeNum(span.endOffset - span.offset);
+            writeNum(static_cast<unsigned int>(token.state) |
+                     (token.moved ? 4U : 0U));
+            writeNum(relative + 1);
+            flushIfFull();
+            continue;
+        }
+
+        if (!first) {
+            buffer += ',';
+        }
+        first = false;
+
+        buffer += "{\"line\":" + std::to_string(node.line)
+                + ",\"col\":" + std::to_string(node.col)
+                + ",\"endLine\":" + std::to_string(span.endLine)
+                + ",\"endCol\":" + std::to_string(span.endCol)
+                + ",\"offset\":" + std::to_string(span.offset)
+                + ",\"endOffset\":" + std::to_string(span.endOffset)
+                + ",\"state\":\"" + toString(token.state) + '"'
+                + ",\"moved\":" + (token.moved ? "true" : "false")
+                + ",\"relative\":" + std::to_string(relative)
+                + '}';
+        flushIfFull();
+    }
+
+    if (json) {
+        buffer += ']';
+    }
+}
+
+void
+Writer::writeNum(std::uint64_t n)
+{
+    do {
+        const char byte = n & 0x7f;
+        n >>= 7;
+        buffer += static_cast<char>(n == 0U ? byte : byte | 0x80);
+    } while (n != 0U);
+}
+
+void
+Writer::flushIfFull()
+{
+    if (buffer.size() >= outputBlockSize) {
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+// Maps tokens' nodes to their indexes.
+static std::unordered_map<const Node *, int>
+indexTokens(const std::vector<Token> &tokens)
+{
+    std::unordered_map<const Node *, int> indexes;
+    indexes.reserve(tokens.size());
+    for (std::size_t i = 0U; i < tokens.size(); ++i) {
+        indexes.emplace(tokens[i].node, i);
+    }
+    return indexes;
+}
+
+// Retrieves name of the state for JSON.
+static const char *
+toString(State state)
+{
+    switch (state) {
+        case State::Unchanged: return "unchanged";
+        case State::Deleted:   return "deleted";
+        case State::Inserted:  return "inserted";
+        case State::Updated:   return "updated";
+    }
+    return "unknown";
+}
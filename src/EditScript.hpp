@@ -0,0 +1,50 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__EDITSCRIPT_HPP__
+#define ZOGRASCOPE__EDITSCRIPT_HPP__
+
+#include <iosfwd>
+#include <string>
+
+class Node;
+
+// Format of serialized results of comparison.
+enum class EditScriptFormat
+{
+    // JSON object with "old" and "new" arrays of tokens.  Each token is an
+    // object with "line", "col", "endLine", "endCol" (one past the last
+    // character), "offset", "endOffset" (one past the last byte), "state"
+    // ("unchanged", "deleted", "inserted" or "updated"), "moved" and
+    // "relative" (index of matched token on the other side or -1).
+    Json,
+    // Magic "ZSES", version byte and then two sequences of tokens (old and
+    // new) each prefixed with number of tokens.  Each token consists of line,
+    // column, number of lines spanned, end column, offset, length in bytes,
+    // flags (state in the lowest two bits and moved flag in the third one) and
+    // index of matched token plus one.  All numbers are unsigned LEB128.
+    Binary
+};
+
+// Writes tokens of two compared trees along with their states and matches into
+// a stream without aligning or highlighting them.  Contents are the ones trees
+// were parsed from, they are used to compute byte offsets of tokens.  Columns
+// count tabulations as advancing to the next tab stop like parsers do.
+void writeEditScript(const Node &left, const std::string &leftContents,
+                     const Node &right, const std::string &rightContents,
+                     EditScriptFormat format, std::ostream &os);
+
+#endif // ZOGRASCOPE__EDITSCRIPT_HPP__
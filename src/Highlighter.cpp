@@ -18,16 +18,19 @@
 
 #include <algorithm>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/functional/hash.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/utility/string_ref.hpp>
 #include <boost/optional.hpp>
-#include "dtl/dtl.hpp"
 
+#include "utils/lcs.hpp"
 #include "utils/strings.hpp"
 #include "ColorCane.hpp"
 #include "Language.hpp"
@@ -39,7 +42,19 @@ static ColorGroup getHighlight(const Node &node, int moved, State state,
                                const Language &lang);
 static bool isDiffable(const Node &node, State state, const Language &lang);
 static std::vector<boost::string_ref> toWords(boost::string_ref s);
-static std::vector<boost::string_ref> toChars(boost::string_ref s);
+
+namespace {
+
+// Hashes contents of a word.
+struct WordHash
+{
+    std::size_t operator()(boost::string_ref word) const
+    {
+        return boost::hash_range(word.begin(), word.end());
+    }
+};
+
+}
 
 class Highlighter::ColorPicker
 {
@@ -158,9 +173,11 @@ leftShift(const Node *node)
 
 Highlighter::Highlighter(const Node &root, const Language &lang, bool original,
                          int lineOffset, int colOffset)
-    : lang(lang), line(lineOffset), col(1), colOffset(colOffset),
+    : lang(lang), printedLines(nullptr), line(lineOffset), col(1),
+      colOffset(colOffset),
       colorPicker(new ColorPicker(lang)), original(original), current(nullptr),
-      printReferences(false), printBrackets(false), transparentDiffables(false)
+      printReferences(false), printBrackets(false), transparentDiffables(false),
+      spellingDiffs(nullptr)
 {
     toProcess.push({ &root, root.moved, root.state, false, false });
 }
@@ -185,6 +202,12 @@ Highlighter::setTransparentDiffables(bool transparent)
     transparentDiffables = transparent;
 }
 
+void
+Highlighter::setSpellingDiffCache(SpellingDiffCache &cache)
+{
+    spellingDiffs = &cache;
+}
+
 ColorCane
 Highlighter::print(int from, int n)
 {
@@ -206,6 +229,19 @@ Highlighter::print()
     return std::move(colorCane);
 }
 
+std::vector<ColorCane>
+Highlighter::printLines()
+{
+    std::vector<ColorCane> printed;
+    printedLines = &printed;
+
+    ColorCane last = print(line, std::numeric_limits<int>::max());
+    printed.push_back(std::move(last));
+
+    printedLines = nullptr;
+    return printed;
+}
+
 void
 Highlighter::skipUntil(int targetLine)
 {
@@ -287,7 +323,7 @@ Highlighter::print(int n)
             if (--n == 0) {
                 return;
             }
-            colorCane.append('\n');
+            breakLine();
             col = colOffset;
         }
 
@@ -315,12 +351,14 @@ Highlighter::printSpelling(int &n)
     auto printLine = [&](ColorCane &cc) {
         std::vector<ColorCane> ccs = std::move(cc).breakAt(" \t");
 
-        for (auto &piece : ccs[0]) {
-            colorCane.append(piece.text, piece.node, piece.hi);
+        for (const ColorCanePiece &piece : ccs[0]) {
+            colorCane.append(piece);
         }
-        for (auto &piece : ccs[1]) {
-            ColorGroup cg = (piece.hi == ColorGroup::None ? hi : piece.hi);
-            colorCane.append(piece.text, piece.node, cg);
+        for (ColorCanePiece piece : ccs[1]) {
+            if (piece.hi == ColorGroup::None) {
+                piece.hi = hi;
+            }
+            colorCane.append(piece);
         }
     };
 
@@ -336,7 +374,7 @@ Highlighter::printSpelling(int &n)
             return;
         }
 
-        colorCane.append('\n');
+        breakLine();
         printLine(lines[i]);
         col = 1 + olines[i].size();
     }
@@ -345,6 +383,17 @@ Highlighter::printSpelling(int &n)
     lines.clear();
 }
 
+void
+Highlighter::breakLine()
+{
+    if (printedLines == nullptr) {
+        colorCane.append('\n');
+    } else {
+        printedLines->push_back(std::move(colorCane));
+        colorCane = ColorCane();
+    }
+}
+
 Highlighter::Entry
 Highlighter::getEntry()
 {
@@ -495,41 +544,22 @@ isDiffable(const Node &node, State state, const Language &lang)
 ColorCane
 Highlighter::diffSpelling(const Node &node)
 {
-    // XXX: some kind of caching would be nice since we're doing the same thing
-    //      for both original and updated nodes.
-
-    boost::string_ref l = (original ? node.spelling : node.relative->spelling);
-    boost::string_ref r = (original ? node.relative->spelling : node.spelling);
-
-    std::vector<boost::string_ref> lWords = toWords(l);
-    std::vector<boost::string_ref> rWords = toWords(r);
-
     const bool surround = node.type == Type::Functions
                        || node.type == Type::Identifiers
                        || node.type == Type::UserTypes;
 
-    if (surround && lWords.size() == 1U && rWords.size() == 1U) {
-        lWords = toChars(l);
-        rWords = toChars(r);
-    }
-
-    auto cmp = [](const boost::string_ref &a, const boost::string_ref &b) {
-        return (a == b);
-    };
-
-    dtl::Diff<boost::string_ref, std::vector<boost::string_ref>,
-              decltype(cmp)> diff(lWords, rWords, cmp);
-    diff.compose();
+    const Node &orig = (original ? node : *node.relative);
+    const Node &upd = (original ? *node.relative : node);
+    SpellingDiffCache &cache = (spellingDiffs == nullptr ? ownSpellingDiffs
+                                                         : *spellingDiffs);
+    const SpellingDiffCache::Result &diff = cache.get(orig, upd, surround);
 
     ColorCane cc;
 
-    float worstDistance = std::max(lWords.size(), rWords.size());
-    float sim = 1.0f - diff.getEditDistance()/worstDistance;
-
     // If Levenshtein distance ends up being too big (similarity is too small),
     // drop comparison results and get back to just printing two nodes as
     // updated.
-    if (sim < 0.2f) {
+    if (!diff.similar) {
         cc.append(node.spelling, &node, ColorGroup::Updated);
         return cc;
     }
@@ -538,60 +568,151 @@ Highlighter::diffSpelling(const Node &node)
         cc.append('[', ColorGroup::UpdatedSurroundings);
     }
 
-    const char *lastL = l.data(), *lastR = r.data();
-
-    auto printLeft = [&](const dtl::elemInfo &info, ColorGroup hi,
-                         ColorGroup def) {
-        const boost::string_ref sr = lWords[info.beforeIdx - 1];
-        cc.append(boost::string_ref(lastL, sr.data() - lastL), &node, def);
-        cc.append(sr, &node, hi);
-        lastL = sr.data() + sr.size();
-    };
-    auto printRight = [&](const dtl::elemInfo &info, ColorGroup hi,
-                          ColorGroup def) {
-        const boost::string_ref sr = rWords[info.afterIdx - 1];
-        cc.append(boost::string_ref(lastR, sr.data() - lastR), &node, def);
-        cc.append(sr, &node, hi);
-        lastR = sr.data() + sr.size();
-    };
-
     // Unchanged parts are highlighted using this color group.
     ColorGroup def = transparentDiffables || !surround
                    ? ColorGroup::None
                    : ColorGroup::PieceUpdated;
+    ColorGroup changed = (original ? ColorGroup::PieceDeleted
+                                   : ColorGroup::PieceInserted);
+
+    const boost::string_ref spelling = node.spelling;
+    std::size_t last = 0U;
+    for (const SpellingDiffCache::Part &part : original ? diff.left
+                                                        : diff.right) {
+        cc.append(spelling.substr(last, part.from - last), &node, def);
+        cc.append(spelling.substr(part.from, part.len), &node,
+                  part.changed ? changed : def);
+        last = part.from + part.len;
+    }
+    cc.append(spelling.substr(last), &node, def);
 
-    for (const auto &x : diff.getSes().getSequence()) {
-        switch (x.second.type) {
-            case dtl::SES_DELETE:
-                if (original) {
-                    printLeft(x.second, ColorGroup::PieceDeleted, def);
-                }
-                break;
-            case dtl::SES_ADD:
-                if (!original) {
-                    printRight(x.second, ColorGroup::PieceInserted, def);
-                }
-                break;
-            case dtl::SES_COMMON:
-                if (original) {
-                    printLeft(x.second, def, def);
-                } else {
-                    printRight(x.second, def, def);
-                }
-                break;
+    if (surround && printBrackets) {
+        cc.append(']', ColorGroup::UpdatedSurroundings);
+    }
+
+    return cc;
+}
+
+const SpellingDiffCache::Result &
+SpellingDiffCache::get(const Node &original, const Node &updated,
+                       bool surround)
+{
+    const Key key = { &original, &updated, surround };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = results.find(key);
+        if (it != results.end()) {
+            return it->second;
         }
     }
 
-    if (original) {
-        cc.append(boost::string_ref(lastL, lastL - l.end()), &node, def);
+    // Computing without holding the lock, the other side might end up doing
+    // the same, in which case the first result wins.
+    Result result = compute(original, updated, surround);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return results.emplace(key, std::move(result)).first->second;
+}
+
+SpellingDiffCache::Result
+SpellingDiffCache::compute(const Node &original, const Node &updated,
+                           bool surround)
+{
+    boost::string_ref l = original.spelling;
+    boost::string_ref r = updated.spelling;
+
+    std::vector<boost::string_ref> lWords = toWords(l);
+    std::vector<boost::string_ref> rWords = toWords(r);
+
+    // Single words are compared by characters.
+    const bool byChars = surround && lWords.size() == 1U
+                      && rWords.size() == 1U;
+
+    std::vector<Edit> script;
+    bool diffed;
+    if (byChars) {
+        diffed = diffBytes(l, r, script);
     } else {
-        cc.append(boost::string_ref(lastR, lastR - r.end()), &node, def);
+        std::unordered_map<boost::string_ref, int, WordHash> ids;
+        auto toIds = [&ids](const std::vector<boost::string_ref> &words) {
+            std::vector<int> seq;
+            seq.reserve(words.size());
+            for (boost::string_ref word : words) {
+                seq.push_back(ids.emplace(word, ids.size()).first->second);
+            }
+            return seq;
+        };
+        const std::vector<int> lIds = toIds(lWords);
+        const std::vector<int> rIds = toIds(rWords);
+        diffed = diffSymbols(lIds, rIds, ids.size(), script);
     }
-    if (surround && printBrackets) {
-        cc.append(']', ColorGroup::UpdatedSurroundings);
+
+    Result result;
+
+    // Inputs that are too big are treated as completely different.
+    if (!diffed) {
+        result.similar = false;
+        return result;
     }
 
-    return cc;
+    const int distance = std::count_if(script.cbegin(), script.cend(),
+                                       [](Edit e) {
+                                           return e != Edit::Common;
+                                       });
+    float worstDistance = byChars ? std::max(l.size(), r.size())
+                                  : std::max(lWords.size(), rWords.size());
+    float sim = 1.0f - distance/worstDistance;
+    result.similar = (sim >= 0.2f);
+    if (!result.similar) {
+        return result;
+    }
+
+    // Adjacent parts of the same kind are merged.
+    auto addPart = [byChars](std::vector<Part> &parts, boost::string_ref whole,
+                             const std::vector<boost::string_ref> &words,
+                             std::size_t idx, bool changed) {
+        Part part = { idx, 1U, changed };
+        if (!byChars) {
+            part.from = words[idx].data() - whole.data();
+            part.len = words[idx].size();
+        }
+
+        if (!parts.empty() && parts.back().changed == changed &&
+            parts.back().from + parts.back().len == part.from) {
+            parts.back().len += part.len;
+        } else {
+            parts.push_back(part);
+        }
+    };
+
+    std::size_t i = 0U, j = 0U;
+    for (Edit edit : script) {
+        switch (edit) {
+            case Edit::Delete:
+                addPart(result.left, l, lWords, i++, true);
+                break;
+            case Edit::Insert:
+                addPart(result.right, r, rWords, j++, true);
+                break;
+            case Edit::Common:
+                addPart(result.left, l, lWords, i++, false);
+                addPart(result.right, r, rWords, j++, false);
+                break;
+        }
+    }
+
+    return result;
+}
+
+std::size_t
+SpellingDiffCache::KeyHash::operator()(const Key &key) const
+{
+    std::size_t seed = 0U;
+    boost::hash_combine(seed, key.original);
+    boost::hash_combine(seed, key.updated);
+    boost::hash_combine(seed, key.surround);
+    return seed;
 }
 
 // Breaks a multi-word string into collection of words.
@@ -626,17 +747,3 @@ toWords(boost::string_ref s)
 
     return words;
 }
-
-// Turns string into a bunch of single character strings.
-static std::vector<boost::string_ref>
-toChars(boost::string_ref s)
-{
-    std::vector<boost::string_ref> chars;
-    chars.reserve(s.size());
-
-    for (std::size_t i = 0U; i < s.size(); ++i) {
-        chars.emplace_back(s.substr(i, 1));
-    }
-
-    return chars;
-}
@@ -17,9 +17,11 @@
 #ifndef ZOGRASCOPE__HIGHLIGHTER_HPP__
 #define ZOGRASCOPE__HIGHLIGHTER_HPP__
 
+#include <cstddef>
 #include <cstdint>
 
 #include <memory>
+#include <mutex>
 #include <stack>
 #include <unordered_map>
 #include <vector>
@@ -34,6 +36,74 @@ class Language;
 class Node;
 class Tree;
 
+// Results of diffing spelling of updated nodes.  Can be shared by highlighters
+// of both versions of a file, so that each pair of nodes is diffed only once.
+// The highlighters can run in different threads.
+class SpellingDiffCache
+{
+public:
+    // Word or character of spelling of one of the nodes.
+    struct Part
+    {
+        std::size_t from; // Offset of the part within spelling.
+        std::size_t len;  // Length of the part.
+        bool changed;     // Whether the part is absent on the other side.
+    };
+
+    // Result of diffing spelling of two nodes.
+    struct Result
+    {
+        bool similar;            // Whether there is enough in common.
+        std::vector<Part> left;  // Parts of spelling of the original node.
+        std::vector<Part> right; // Parts of spelling of the updated node.
+    };
+
+public:
+    // Retrieves result of diffing spelling of two nodes computing it on the
+    // first request.  Surrounded spellings consisting of single words are
+    // compared by characters.
+    const Result & get(const Node &original, const Node &updated,
+                       bool surround);
+    // Retrieves number of computed results.
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return results.size();
+    }
+
+private:
+    // Identifies comparison.
+    struct Key
+    {
+        const Node *original; // Original node.
+        const Node *updated;  // Updated node.
+        bool surround;        // Whether spelling is surrounded.
+
+        // Checks whether two keys are equal.
+        bool operator==(const Key &rhs) const
+        {
+            return original == rhs.original
+                && updated == rhs.updated
+                && surround == rhs.surround;
+        }
+    };
+
+    // Computes hash of a key.
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const;
+    };
+
+private:
+    // Diffs spelling of two nodes.
+    static Result compute(const Node &original, const Node &updated,
+                          bool surround);
+
+private:
+    std::unordered_map<Key, Result, KeyHash> results; // Computed results.
+    mutable std::mutex mutex;                         // Protects `results`.
+};
+
 // Tree highlighter.  Highlights either all at once or by line ranges.
 class Highlighter
 {
@@ -87,6 +157,9 @@ public:
     // Specifies whether unchanged parts diffables should have their original
     // color.  If not, they are colored as `PieceUpdated`.  On by default.
     void setTransparentDiffables(bool transparent);
+    // Specifies cache of diffs of spelling to use instead of the internal one.
+    // The cache must outlive the highlighter.
+    void setSpellingDiffCache(SpellingDiffCache &cache);
 
     // Prints lines in the range [from, from + n).  Each line can be printed at
     // most once, thus calls to this function need to increase `from` argument.
@@ -95,6 +168,10 @@ public:
     // Prints lines until the end.
     ColorCane print();
 
+    // Prints lines until the end in a single pass.  Element #i of the result
+    // corresponds to line `i` lines after the current one.
+    std::vector<ColorCane> printLines();
+
 private:
     // Skips everything until target line is reached.
     void skipUntil(int targetLine);
@@ -102,6 +179,8 @@ private:
     void print(int n);
     // Prints lines of spelling decreasing `n` on advancing through lines.
     void printSpelling(int &n);
+    // Ends current line of output.
+    void breakLine();
     // Retrieves the next entry to be processed.
     Entry getEntry();
     // Advances processing to the next node.  The entry here is the one that was
@@ -115,6 +194,7 @@ private:
 private:
     const Language &lang;                     // Language services.
     ColorCane colorCane;                      // Temporary output buffer.
+    std::vector<ColorCane> *printedLines;     // Completed lines or nullptr.
     int line, col;                            // Current position.
     int colOffset;                            // Horizontal offset.
     std::unique_ptr<ColorPicker> colorPicker; // Highlighting state.
@@ -129,6 +209,8 @@ private:
     bool printBrackets;                       // Bracket diffed identifiers.
     bool transparentDiffables;                // Leave unchanged parts of
                                               // diffables with original color.
+    SpellingDiffCache ownSpellingDiffs;       // Default cache of diffs.
+    SpellingDiffCache *spellingDiffs;         // External cache or nullptr.
 };
 
 #endif // ZOGRASCOPE__HIGHLIGHTER_HPP__
@@ -30,6 +30,7 @@
 #include "c/C11Language.hpp"
 #include "make/MakeLanguage.hpp"
 #include "srcml/cxx/SrcmlCxxLanguage.hpp"
+#include "TreeBuilder.hpp"
 #include "tree.hpp"
 
 namespace fs = boost::filesystem;
@@ -107,6 +108,14 @@ detectLanguage(const std::string &stem, const std::string &ext)
     return {};
 }
 
+TreeBuilder
+Language::reparse(const std::string &contents, const std::string &fileName,
+                  bool debug, ParseCache &/*cache*/,
+                  cpp17::pmr::monolithic &mr) const
+{
+    return parse(contents, fileName, debug, mr);
+}
+
 bool
 Language::isDiffable(const Node *x) const
 {
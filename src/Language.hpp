@@ -29,6 +29,7 @@ namespace cpp17 {
 }
 
 class Node;
+class ParseCache;
 class TreeBuilder;
 
 enum class MType : std::uint8_t;
@@ -60,6 +61,14 @@ public:
                               const std::string &fileName,
                               bool debug,
                               cpp17::pmr::monolithic &mr) const = 0;
+    // Parses source file into a tree reusing parts of trees of its previous
+    // versions from the cache.  Resulting tree is allocated from `mr` and
+    // doesn't depend on the cache.  By default the cache is ignored.
+    virtual TreeBuilder reparse(const std::string &contents,
+                                const std::string &fileName,
+                                bool debug,
+                                ParseCache &cache,
+                                cpp17::pmr::monolithic &mr) const;
 
     // Checks whether node doesn't have fixed position within a tree and can
     // move between internal nodes as long as post-order of leafs is preserved.
@@ -0,0 +1,51 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ParseCache.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+std::unique_ptr<ParseCache::Piece>
+ParseCache::take(boost::string_ref text)
+{
+    auto it = available.find(text);
+    if (it == available.end()) {
+        return {};
+    }
+
+    std::unique_ptr<Piece> piece = std::move(it->second);
+    available.erase(it);
+    return piece;
+}
+
+void
+ParseCache::add(std::unique_ptr<Piece> piece)
+{
+    added.push_back(std::move(piece));
+}
+
+void
+ParseCache::commit()
+{
+    available.clear();
+    for (std::unique_ptr<Piece> &piece : added) {
+        const boost::string_ref text = piece->text;
+        available.emplace(text, std::move(piece));
+    }
+    added.clear();
+}
@@ -0,0 +1,92 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__PARSECACHE_HPP__
+#define ZOGRASCOPE__PARSECACHE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include "pmr/monolithic.hpp"
+
+#include "TreeBuilder.hpp"
+
+// Independently parsed pieces of the last parsed version of a file, which can
+// be reused to parse the next version if some pieces remain unchanged.  All
+// versions must be parsed as the same language.  Only parsing is incremental:
+// the whole input is still split and hashed to find pieces, while `Tree` is
+// built out of the whole parse tree and compared in full.  Trees of pieces
+// aren't modified once they are in the cache.
+class ParseCache
+{
+public:
+    // Piece of a file along with its parse tree.
+    struct Piece
+    {
+        Piece(std::string text,
+              std::unique_ptr<cpp17::pmr::monolithic> mr,
+              TreeBuilder &&tb)
+            : text(std::move(text)), mr(std::move(mr)), tb(std::move(tb))
+        { }
+
+        std::string text;                        // Contents of the piece.
+        std::unique_ptr<cpp17::pmr::monolithic> mr; // Storage of the tree.
+        TreeBuilder tb;                          // Parse tree.
+        std::uint32_t offset = 0U; // Offset of leafs of the tree.
+        int line = 1;              // Line at which leafs of the tree start.
+    };
+
+public:
+    // Takes out a piece of the previous version with specified contents.
+    // Returns nullptr if there is no such piece.
+    std::unique_ptr<Piece> take(boost::string_ref text);
+
+    // Adds a piece of the current version.
+    void add(std::unique_ptr<Piece> piece);
+
+    // Finishes processing of the current version.  Its pieces become available
+    // for reuse, while pieces of the previous version that weren't taken are
+    // freed.
+    void commit();
+
+private:
+    // Hashes contents of pieces.
+    struct TextHash
+    {
+        std::size_t operator()(boost::string_ref text) const
+        {
+            return boost::hash_range(text.begin(), text.end());
+        }
+    };
+
+private:
+    // Pieces available for reuse keyed by their own text.
+    std::unordered_multimap<boost::string_ref, std::unique_ptr<Piece>,
+                            TextHash> available;
+    // Pieces of the current version.
+    std::vector<std::unique_ptr<Piece>> added;
+};
+
+#endif // ZOGRASCOPE__PARSECACHE_HPP__
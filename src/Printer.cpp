@@ -16,9 +16,14 @@
 
 #include "Printer.hpp"
 
+#include <cstddef>
+
+#include <algorithm>
 #include <functional>
+#include <future>
 #include <iomanip>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -35,6 +40,11 @@
 #include "tree.hpp"
 #include "tree-edit-distance.hpp"
 
+// Output is written in blocks of about this size.
+static const std::size_t outputBlockSize = 64*1024;
+
+static unsigned int measureWidth(boost::string_ref s);
+
 namespace {
 
 class LayoutBuilder;
@@ -46,8 +56,7 @@ class Layout
 
 private:
     // Reference to the builder is saved, so it should outlive layout.
-    explicit Layout(const LayoutBuilder &builder,
-                    std::vector<int> &&leftWidths);
+    explicit Layout(const LayoutBuilder &builder);
 
 public:
     // Retrieves width of a marker used in left part of header line.
@@ -76,9 +85,9 @@ public:
     int getMaxRightWidth() const { return maxRightWidth; }
 
     // Retrieves width for string on the left.
-    int getLeftWidth(boost::string_ref ll, int idx) const
+    int getLeftWidth(boost::string_ref ll) const
     {
-        const int extraWidth = ll.size() - leftWidths[idx];
+        const int extraWidth = ll.size() - measureWidth(ll);
         if (rightVisible) {
             return maxLeftWidth + extraWidth;
         }
@@ -141,8 +150,6 @@ private:
 
     int wholeWidth, usefulWidth;
     int leftWidth, rightWidth;
-
-    std::vector<int> leftWidths;
 };
 
 // Collects information needed to compute layout.
@@ -187,23 +194,17 @@ public:
     }
 
     // Records width of a line on the left part.
-    void measureLeft(const std::string &line)
+    void measureLeft(int width)
     {
-        if (!leftVisible) {
-            leftWidths.push_back(0);
-            return;
+        if (leftVisible) {
+            maxLeftWidth = std::max(width, maxLeftWidth);
         }
-
-        const int width = measureWidth(line);
-        leftWidths.push_back(width);
-        maxLeftWidth = std::max(width, maxLeftWidth);
     }
 
     // Records width of a line on the right part.
-    void measureRight(const std::string &line)
+    void measureRight(int width)
     {
         if (rightVisible) {
-            const int width = measureWidth(line);
             maxRightWidth = std::max(width, maxRightWidth);
         }
     }
@@ -213,30 +214,7 @@ public:
     {
         maxLeftWidth = std::max(maxLeftWidth, maxLeftHeaderWidth);
         maxRightWidth = std::max(maxRightWidth, maxRightHeaderWidth);
-        return Layout(*this, std::move(leftWidths));
-    }
-
-private:
-    // Calculates width of a string ignoring embedded escape sequences.
-    static unsigned int measureWidth(boost::string_ref s)
-    {
-        // XXX: we actually print lines without formatting and should be able to
-        //      avoid using this function.
-        unsigned int valWidth = 0U;
-        while (!s.empty()) {
-            if (s.front() != '\033') {
-                ++valWidth;
-                s.remove_prefix(1);
-                continue;
-            }
-
-            const auto width = s.find('m');
-            if (width == std::string::npos) {
-                break;
-            }
-            s.remove_prefix(width + 1U);
-        }
-        return valWidth;
+        return Layout(*this);
     }
 
 private:
@@ -245,12 +223,9 @@ private:
     int maxLeftHeaderWidth = 0, maxRightHeaderWidth = 0;
     int maxLeftWidth = 0, maxRightWidth = 0;
     int maxLeftNum = 0, maxRightNum = 0;
-
-    std::vector<int> leftWidths;
 };
 
-Layout::Layout(const LayoutBuilder &builder, std::vector<int> &&leftWidths)
-    : leftWidths(std::move(leftWidths))
+Layout::Layout(const LayoutBuilder &builder)
 {
     leftVisible = builder.leftVisible;
     rightVisible = builder.rightVisible;
@@ -274,19 +249,25 @@ Layout::Layout(const LayoutBuilder &builder, std::vector<int> &&leftWidths)
 }
 
 // This class is responsible for formatting output while printing it to a
-// stream.
+// stream.  Output is accumulated in a buffer and written in large blocks.
 class Outliner
 {
 public:
     // Reference to layout is saved, so it should outlive outliner.
     Outliner(std::ostream &os, const Layout &layout) : os(os), layout(layout)
     {
+        using namespace decor::literals;
+
         leftMarker = ' '
                    + std::string(layout.getLeftMarkerWidth(), '-')
                    + "  ";
         rightMarker = ' '
                     + std::string(layout.getRightMarkerWidth(), '+')
                     + "  ";
+
+        lineNo = decor::precompile(cs[ColorGroup::LineNo]);
+        blank = decor::precompile(235_bg);
+        buffer.reserve(outputBlockSize);
     }
 
 public:
@@ -295,12 +276,13 @@ public:
     {
         using namespace decor::literals;
 
-        os << std::setfill('~')
-           << std::setw(layout.getLeftHeaderWidth() + 1) << (231_fg << "")
-           << (decor::bold << '!')
-           << std::setw(layout.getRightHeaderWidth() + 1) << (231_fg << "")
-           << std::setfill(' ')
-           << '\n';
+        std::ostringstream oss;
+        oss << std::setfill('~')
+            << std::setw(layout.getLeftHeaderWidth() + 1) << (231_fg << "")
+            << (decor::bold << '!')
+            << std::setw(layout.getRightHeaderWidth() + 1) << (231_fg << "")
+            << '\n';
+        buffer += oss.str();
     }
 
     // Prints single header.
@@ -309,13 +291,15 @@ public:
         using namespace decor::literals;
 
         auto title = 231_fg + decor::bold;
-        os << (title << std::left
-                     << std::setw(layout.getLeftHeaderWidth())
-                     << leftMarker + hdr.left
-                     << " ! "
-                     << std::setw(layout.getRightHeaderWidth())
-                     << rightMarker + hdr.right)
-           << '\n';
+        std::ostringstream oss;
+        oss << (title << std::left
+                      << std::setw(layout.getLeftHeaderWidth())
+                      << leftMarker + hdr.left
+                      << " ! "
+                      << std::setw(layout.getRightHeaderWidth())
+                      << rightMarker + hdr.right)
+            << '\n';
+        buffer += oss.str();
     }
 
     // Prints a horizontally centered message.
@@ -326,17 +310,20 @@ public:
         int leftFill, rightFill;
         layout.centerMsg(msg, leftFill, rightFill);
 
-        os << std::right << std::setfill('.')
-           << (251_fg << std::setw(leftFill) << "")
-           << msg
-           << (251_fg << std::setw(rightFill) << "")
-           << '\n' << std::setfill(' ');
+        std::ostringstream oss;
+        oss << std::right << std::setfill('.')
+            << (251_fg << std::setw(leftFill) << "")
+            << msg
+            << (251_fg << std::setw(rightFill) << "")
+            << '\n';
+        buffer += oss.str();
+        flushIfFull();
     }
 
     // Prints line of the left part.
     void printLeftLine(int lineNum, boost::string_ref str)
     {
-        const int width = layout.getLeftWidth(str, leftWidthIndex++);
+        const int width = layout.getLeftWidth(str);
         printLine(lineNum, str, layout.getLeftNumWidth(), width);
     }
 
@@ -363,18 +350,26 @@ public:
     void printMarker(char marker, ColorGroup color)
     {
         if (layout.isLeftVisible()) {
-            os << ' ';
+            buffer += ' ';
         }
-        os << (cs[color] << marker);
+        cs.print(buffer, color, boost::string_ref(&marker, 1U));
         if (layout.isRightVisible()) {
-            os << ' ';
+            buffer += ' ';
         }
     }
 
     // Advances to next line of parts.
     void nextLine()
     {
-        os << '\n';
+        buffer += '\n';
+        flushIfFull();
+    }
+
+    // Writes out buffered output.
+    void flush()
+    {
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
     }
 
 private:
@@ -382,19 +377,46 @@ private:
     void printLine(int lineNum, boost::string_ref str,
                    int numColWidth, int width)
     {
-        os << (lineNo << std::right << std::setw(numColWidth) << lineNum << ' ')
-           << ' ' << std::left << std::setw(width) << str;
+        buffer += lineNo.first;
+        pad(std::to_string(lineNum), numColWidth, false);
+        buffer += ' ';
+        buffer += lineNo.second;
+        buffer += ' ';
+        pad(str, width, true);
     }
 
     // Formats and prints single blank line with its line number.
     void printBlank(int lineNum, int numColWidth, int width)
     {
-        using namespace decor::literals;
+        buffer += lineNo.first;
+        pad(noLineMarker(lineNum) + ' ', numColWidth + 1, false);
+        buffer += lineNo.second;
+        buffer += ' ';
+        buffer += blank.first;
+        buffer.append(std::max(width, 0), ' ');
+        buffer += blank.second;
+    }
 
-        os << (lineNo << std::right << std::setw(numColWidth + 1)
-                      << (noLineMarker(lineNum) + ' '))
-           << ' ' << std::left << std::setw(width)
-           << (235_bg << "");
+    // Appends string padding it with spaces to be at least `width` characters
+    // long.
+    void pad(boost::string_ref str, int width, bool left)
+    {
+        const int fill = std::max(0, width - static_cast<int>(str.size()));
+        if (!left) {
+            buffer.append(fill, ' ');
+        }
+        buffer.append(str.data(), str.size());
+        if (left) {
+            buffer.append(fill, ' ');
+        }
+    }
+
+    // Writes out buffered output if there is enough of it.
+    void flushIfFull()
+    {
+        if (buffer.size() >= outputBlockSize) {
+            flush();
+        }
     }
 
     // Generates string that should be used instead of line number.  Takes line
@@ -409,13 +431,50 @@ private:
     const Layout &layout;    // Computed layout.
     std::string leftMarker;  // Left marker for headers.
     std::string rightMarker; // Right marker for headers.
+    std::string buffer;      // Output that wasn't written yet.
 
     // Color scheme.
     ColorScheme cs;
-    // Line number style.
-    decor::Decoration lineNo = cs[ColorGroup::LineNo];
-    // Next line index of the left part (needed to correct maximum width).
-    int leftWidthIndex = 0;
+    // Sequences surrounding line numbers.
+    std::pair<std::string, std::string> lineNo;
+    // Sequences surrounding filler of blank lines.
+    std::pair<std::string, std::string> blank;
+};
+
+// Supplies highlighted and annotated lines of one side of a diff.
+class LineSource
+{
+public:
+    // Lines aren't rendered if the side is not visible.
+    LineSource(const Node &root, const Language &lang, bool original,
+               const std::vector<std::string> &annots, std::size_t nLines,
+               bool visible, SpellingDiffCache &spellingDiffs)
+    {
+        if (!visible) {
+            return;
+        }
+
+        TermHighlighter hi(root, lang, original);
+        hi.setSpellingDiffCache(spellingDiffs);
+        lines = hi.printLines();
+        lines.resize(nLines);
+
+        for (std::size_t i = 0U; i < lines.size() && i < annots.size(); ++i) {
+            lines[i].insert(lines[i].begin(), annots[i].cbegin(),
+                            annots[i].cend());
+        }
+    }
+
+public:
+    // Retrieves line by its index.
+    const std::string & operator[](int idx) const
+    {
+        static const std::string empty;
+        return (idx < static_cast<int>(lines.size()) ? lines[idx] : empty);
+    }
+
+private:
+    std::vector<std::string> lines; // Rendered lines.
 };
 
 }
@@ -446,29 +505,36 @@ Printer::print(TimeReport &tr)
 {
     auto diffingTimer = tr.measure("printing");
 
-    // Do comparison without highlighting as it skews alignment results.
+    // Do comparison without highlighting as it skews alignment results.  Sides
+    // are independent and are prepared in parallel.
+    TimeReport nestedTr(tr);
+    std::future<DiffSource> rsrcFuture = std::async(std::launch::async, [&]() {
+        return (nestedTr.measure("right-align-print"), DiffSource(right));
+    });
     DiffSource lsrc = (tr.measure("left-align-print"), DiffSource(left));
-    DiffSource rsrc = (tr.measure("right-align-print"), DiffSource(right));
+    DiffSource rsrc = rsrcFuture.get();
+    nestedTr.commit();
+
     std::vector<DiffLine> diff = (tr.measure("align"),
                                   makeDiff(std::move(lsrc), std::move(rsrc)));
 
     auto timer = tr.measure("printing");
 
-    TermHighlighter lh(left, lang, true);
-    TermHighlighter rh(right, lang, false);
-    std::vector<std::string> l(lsrc.lines.size());
-    std::vector<std::string> r(rsrc.lines.size());
-
     LayoutBuilder layoutBuilder(lsrc, rsrc, headers);
 
-    auto annotate = [](std::string &str,
-                       const std::vector<std::string> &annots,
-                       std::size_t index) {
-        if (index < annots.size()) {
-            str.insert(str.begin(),
-                       annots[index].cbegin(), annots[index].cend());
-        }
-    };
+    // Both sides and repeated renderings share results of diffing spellings.
+    SpellingDiffCache spellingDiffs;
+
+    // Sides are rendered in parallel.  Highlighting is done for all lines at
+    // once, which is linear in the size of the tree unlike highlighting lines
+    // one by one.
+    std::future<LineSource> rFuture = std::async(std::launch::async, [&]() {
+        return LineSource(right, lang, false, rightAnnots, rsrc.lines.size(),
+                          layoutBuilder.isRightVisible(), spellingDiffs);
+    });
+    const LineSource l(left, lang, true, leftAnnots, lsrc.lines.size(),
+                       layoutBuilder.isLeftVisible(), spellingDiffs);
+    const LineSource r = rFuture.get();
 
     unsigned int i = 0U, j = 0U;
     for (DiffLine d : diff) {
@@ -479,18 +545,10 @@ Printer::print(TimeReport &tr)
         }
 
         if (d.type != Diff::Right) {
-            if (layoutBuilder.isLeftVisible()) {
-                l[i] = lh.print(i + 1, 1);
-                annotate(l[i], leftAnnots, i);
-            }
-            layoutBuilder.measureLeft(l[i++]);
+            layoutBuilder.measureLeft(measureWidth(l[i++]));
         }
         if (d.type != Diff::Left) {
-            if (layoutBuilder.isRightVisible()) {
-                r[j] = rh.print(j + 1, 1);
-                annotate(r[j], rightAnnots, j);
-            }
-            layoutBuilder.measureRight(r[j++]);
+            layoutBuilder.measureRight(measureWidth(r[j++]));
         }
 
         // Record last non-folded indices.
@@ -560,4 +618,29 @@ Printer::print(TimeReport &tr)
 
         outliner.nextLine();
     }
+
+    outliner.flush();
+}
+
+// Calculates width of a string ignoring embedded escape sequences.
+static unsigned int
+measureWidth(boost::string_ref s)
+{
+    // XXX: we actually print lines without formatting and should be able to
+    //      avoid using this function.
+    unsigned int valWidth = 0U;
+    while (!s.empty()) {
+        if (s.front() != '\033') {
+            ++valWidth;
+            s.remove_prefix(1);
+            continue;
+        }
+
+        const auto width = s.find('m');
+        if (width == std::string::npos) {
+            break;
+        }
+        s.remove_prefix(width + 1U);
+    }
+    return valWidth;
 }
@@ -16,6 +16,8 @@
 
 #include "STree.hpp"
 
+#include <cstddef>
+
 #include <deque>
 #include <iostream>
 #include <utility>
@@ -28,7 +30,6 @@
 
 static void print(const PNode *node, const std::string &contents,
                   Language &lang);
-static PNode * findSNode(PNode *node);
 static SNode * makeSNode(Pool<SNode> &snodes, const std::string &contents,
                          Language &lang, PNode *pnode, bool dumpUnclear);
 
@@ -70,43 +71,83 @@ print(const PNode *node, const std::string &contents, Language &lang)
     });
 }
 
-static PNode *
+PNode *
 findSNode(PNode *node)
 {
-    if (node->stype != SType{}) {
-        return node;
+    while (node->stype == SType{}) {
+        if (node->children.size() != 1U) {
+            return nullptr;
+        }
+        node = node->children.front();
     }
+    return node;
+}
 
-    return node->children.size() == 1U
-         ? findSNode(node->children.front())
-         : nullptr;
+bool
+findChildSNodes(const PNode *node, std::vector<PNode *> &found)
+{
+    bool any = false;
+    for (PNode *child : node->children) {
+        PNode *schild = findSNode(child);
+        found.push_back(schild);
+        any |= (schild != nullptr);
+    }
+    return any;
 }
 
+// Builds SNode-tree out of PNode-tree in a single pass without recursion.
 static SNode *
 makeSNode(Pool<SNode> &pool, const std::string &contents, Language &lang,
           PNode *pnode, bool dumpUnclear)
 {
-    SNode *snode = pool.make(pnode);
-
-    auto isSNode = [](PNode *child) {
-        return (findSNode(child) != nullptr);
+    struct Frame
+    {
+        SNode *snode;      // Node whose children are being made.
+        std::size_t first; // Index of the first child's entry in `found`.
+        std::size_t next;  // Index of the next child to process.
     };
-    // If none of the children is SNode, then current node is a leaf SNode.
-    if (std::none_of(pnode->children.begin(), pnode->children.end(), isSNode)) {
+
+    // Results of findSNode() for children of nodes on the stack.
+    std::vector<PNode *> found;
+    std::vector<Frame> stack;
+
+    // Makes SNode and schedules processing of its children unless it's a leaf.
+    auto enter = [&](PNode *pnode) {
+        SNode *snode = pool.make(pnode);
+
+        const std::size_t first = found.size();
+        if (!findChildSNodes(pnode, found)) {
+            found.resize(first);
+        } else {
+            snode->children.reserve(pnode->children.size());
+            stack.push_back({ snode, first, 0U });
+        }
         return snode;
-    }
+    };
+
+    SNode *root = enter(pnode);
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        SNode *const snode = frame.snode;
+        PNode *const parent = snode->value;
+
+        if (frame.next == parent->children.size()) {
+            found.resize(frame.first);
+            stack.pop_back();
+            continue;
+        }
 
-    cpp17::pmr::vector<SNode *> &c = snode->children;
-    c.reserve(pnode->children.size());
-    for (PNode *child : pnode->children) {
-        if (PNode *schild = findSNode(child)) {
-            c.push_back(makeSNode(pool, contents, lang, schild, dumpUnclear));
+        const std::size_t i = frame.next++;
+        if (PNode *schild = found[frame.first + i]) {
+            // This invalidates `frame`.
+            snode->children.push_back(enter(schild));
         } else {
+            PNode *child = parent->children[i];
             if (dumpUnclear) {
                 print(child, contents, lang);
             }
-            c.push_back(pool.make(pnode->children[c.size()]));
+            snode->children.push_back(pool.make(child));
         }
     }
-    return snode;
+    return root;
 }
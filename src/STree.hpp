@@ -18,6 +18,7 @@
 #define ZOGRASCOPE__STREE_HPP__
 
 #include <string>
+#include <vector>
 
 #include "pmr/pmr_vector.hpp"
 
@@ -66,4 +67,19 @@ private:
     SNode *root;
 };
 
+// Finds PNode that defines SNode by skipping chain of single-child nodes without
+// SType.  Returns nullptr if there is no such node.
+PNode * findSNode(PNode *node);
+
+inline const PNode *
+findSNode(const PNode *node)
+{
+    return findSNode(const_cast<PNode *>(node));
+}
+
+// Appends results of findSNode() for each child of the node to `found`.
+// Returns `false` if none of the children is SNode, which makes the node a leaf
+// SNode.
+bool findChildSNodes(const PNode *node, std::vector<PNode *> &found);
+
 #endif // ZOGRASCOPE__STREE_HPP__
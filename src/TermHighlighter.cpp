@@ -16,27 +16,39 @@
 
 #include "TermHighlighter.hpp"
 
-#include <sstream>
 #include <string>
+#include <vector>
 
 #include "ColorCane.hpp"
 
 std::string
 TermHighlighter::print(int from, int n)
 {
-    std::ostringstream oss;
-    for (const ColorCanePiece &piece : Highlighter::print(from, n)) {
-        oss << (cs[piece.hi] << piece.text);
-    }
-    return oss.str();
+    return toString(Highlighter::print(from, n));
 }
 
 std::string
 TermHighlighter::print()
 {
-    std::ostringstream oss;
-    for (const ColorCanePiece &piece : Highlighter::print()) {
-        oss << (cs[piece.hi] << piece.text);
+    return toString(Highlighter::print());
+}
+
+std::vector<std::string>
+TermHighlighter::printLines()
+{
+    std::vector<std::string> lines;
+    for (const ColorCane &cc : Highlighter::printLines()) {
+        lines.push_back(toString(cc));
+    }
+    return lines;
+}
+
+std::string
+TermHighlighter::toString(const ColorCane &cc) const
+{
+    std::string str;
+    for (const ColorCanePiece &piece : cc) {
+        cs.print(str, piece.hi, piece.text);
     }
-    return oss.str();
+    return str;
 }
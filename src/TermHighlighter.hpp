@@ -18,6 +18,7 @@
 #define ZOGRASCOPE__TERMHIGHLIGHTER_HPP__
 
 #include <string>
+#include <vector>
 
 #include "ColorScheme.hpp"
 #include "Highlighter.hpp"
@@ -33,6 +34,7 @@ public:
     using Highlighter::setPrintReferences;
     using Highlighter::setPrintBrackets;
     using Highlighter::setTransparentDiffables;
+    using Highlighter::setSpellingDiffCache;
 
     // Prints lines in the range [from, from + n) into a string.  Each line can
     // be printed at most once, thus calls to this function need to increase
@@ -40,6 +42,13 @@ public:
     std::string print(int from, int n);
     // Prints lines until the end into a string.  Returns the string.
     std::string print();
+    // Prints lines until the end into separate strings in a single pass.
+    // Returns the strings with the first one being the current line.
+    std::vector<std::string> printLines();
+
+private:
+    // Converts colored text into a string.
+    std::string toString(const ColorCane &cc) const;
 
 private:
     ColorScheme cs; // Terminal color scheme.
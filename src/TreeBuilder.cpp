@@ -18,6 +18,7 @@
 
 #include <cstddef>
 
+#include <algorithm>
 #include <functional>
 #include <utility>
 
@@ -41,14 +42,21 @@ TreeBuilder::addNode(Text value, const Location &loc, int token, SType stype)
     value.token = token;
 
     if (value.postponedFrom != value.postponedTo) {
-        PNode *const node = addNode();
-        node->children.reserve(value.postponedTo - value.postponedFrom + 1U);
+        // Postponed nodes are grouped so that lifting them up the tree costs
+        // the same regardless of their number.
+        PNode *const group = addNode();
+        group->postponed = true;
+        group->children.reserve(value.postponedTo - value.postponedFrom);
         for (std::size_t i = value.postponedFrom; i < value.postponedTo; ++i) {
-            node->children.push_back(pool.make(postponed[i].value,
-                                               postponed[i].loc,
-                                               postponed[i].stype,
-                                               true));
+            group->children.push_back(pool.make(postponed[i].value,
+                                                postponed[i].loc,
+                                                postponed[i].stype,
+                                                true));
         }
+
+        PNode *const node = addNode();
+        node->children.reserve(2U);
+        node->children.push_back(group);
         node->children.push_back(pool.make(value, loc, stype, false));
         return node;
     }
@@ -59,20 +67,25 @@ TreeBuilder::addNode(Text value, const Location &loc, int token, SType stype)
 PNode *
 TreeBuilder::addNode(const std::initializer_list<PNode *> &ini, SType stype)
 {
-    cpp17::pmr::vector<PNode *> children(ini, alloc);
+    // Children are collected on a stack shared by all calls, which lets us
+    // allocate list of children of the new node once and of exact size.
+    stack.clear();
 
     // Lifts postponed nodes from children inserting them right before them in
     // children's list of their future parent.
-    for (unsigned int i = children.size(); i != 0U; --i) {
-        movePostponed(children[i - 1U], children, children.cbegin() + (i - 1U));
+    for (PNode *child : ini) {
+        movePostponed(child, stack, stack.cend());
+        stack.push_back(child);
     }
 
     // Contract nodes here to avoid creating node that will be thrown away later
     // in PNode.
-    if (stype == SType{} && children.size() == 1U) {
-        return PNode::contract(children[0]);
+    if (stype == SType{} && stack.size() == 1U) {
+        return PNode::contract(stack[0]);
     }
 
+    CompactVector<PNode *> children(alloc);
+    children.assign(stack.cbegin(), stack.cend());
     return pool.make(std::move(children), stype);
 }
 
@@ -93,25 +106,46 @@ TreeBuilder::finish(bool failed)
     }
 }
 
+// Checks whether node is a group of postponed nodes.
+static bool
+isGroup(const PNode *node)
+{
+    return node->postponed && !node->children.empty();
+}
+
 // Drops children of each node within the tree that were "moved" to some parent
-// nodes.  Returns contracted node.
+// nodes and replaces groups of postponed nodes with their contents.  Returns
+// contracted node.
 static PNode *
 shrinkTree(PNode *node)
 {
-    cpp17::pmr::vector<PNode *> &children = node->children;
+    CompactVector<PNode *> &children = node->children;
     children.erase(children.begin(),
                    children.begin() + node->movedChildren);
     for (PNode *&child : children) {
         child = shrinkTree(child);
     }
 
+    if (std::any_of(children.cbegin(), children.cend(), &isGroup)) {
+        CompactVector<PNode *> expanded(children.get_allocator());
+        for (PNode *child : children) {
+            if (isGroup(child)) {
+                expanded.insert(expanded.cend(), child->children.cbegin(),
+                                child->children.cend());
+            } else {
+                expanded.push_back(child);
+            }
+        }
+        children.swap(expanded);
+    }
+
     node->movedChildren = 0;
     return PNode::contract(node);
 }
 
 void
-TreeBuilder::movePostponed(PNode *&node, cpp17::pmr::vector<PNode *> &nodes,
-                          cpp17::pmr::vector<PNode *>::const_iterator insertPos)
+TreeBuilder::movePostponed(PNode *&node, CompactVector<PNode *> &nodes,
+                          CompactVector<PNode *>::const_iterator insertPos)
 {
     auto pos = std::find_if_not(node->children.begin(), node->children.end(),
                                 [](PNode *n) { return n->postponed; });
@@ -27,6 +27,7 @@
 #include "pmr/monolithic.hpp"
 #include "pmr/pmr_vector.hpp"
 
+#include "utils/CompactVector.hpp"
 #include "utils/Pool.hpp"
 
 enum class SType : std::uint8_t;
@@ -50,10 +51,17 @@ struct PNode
 {
     using allocator_type = cpp17::pmr::polymorphic_allocator<cpp17::byte>;
 
+    // Part of Text that is kept in the tree.
+    struct Value
+    {
+        std::uint32_t from, len;
+        int token;
+    };
+
     PNode(allocator_type al = {}) : children(al)
     {
     }
-    PNode(cpp17::pmr::vector<PNode *> children, SType stype = {},
+    PNode(CompactVector<PNode *> children, SType stype = {},
           allocator_type al = {})
         : children(std::move(children), al), stype(stype)
     {
@@ -64,8 +72,9 @@ struct PNode
     PNode(Text value, const Location &loc, SType stype = {},
           bool postponed = false,
           allocator_type al = {})
-        : children(al), value(value), line(loc.first_line),
-          col(loc.first_column), stype(stype), postponed(postponed)
+        : children(al), value{ value.from, value.len, value.token },
+          line(loc.first_line), col(loc.first_column), stype(stype),
+          postponed(postponed)
     {
     }
 
@@ -89,9 +98,12 @@ struct PNode
         return node;
     }
 
-    cpp17::pmr::vector<PNode *> children;
-    Text value = { 0U, 0U, 0U, 0U, 0 };
+    CompactVector<PNode *> children;
+    Value value = { 0U, 0U, 0 };
     int line = 0, col = 0;
+    // Transient identifier of the node that is assigned and used while the
+    // node is being turned into Node.
+    std::uint32_t id = 0U;
     short movedChildren = 0;
     SType stype = {};
     bool postponed = false;
@@ -112,7 +124,7 @@ class TreeBuilder
 
 public:
     TreeBuilder(cpp17::pmr::monolithic &mr)
-        : alloc(&mr), pool(&mr), postponed(&mr)
+        : alloc(&mr), pool(&mr), postponed(&mr), stack(&mr)
     {
     }
     TreeBuilder(const TreeBuilder &rhs) = delete;
@@ -209,14 +221,16 @@ public:
     }
 
 private:
-    void movePostponed(PNode *&node, cpp17::pmr::vector<PNode *> &nodes,
-                       cpp17::pmr::vector<PNode *>::const_iterator insertPos);
+    void movePostponed(PNode *&node, CompactVector<PNode *> &nodes,
+                       CompactVector<PNode *>::const_iterator insertPos);
 
 private:
     cpp17::pmr::polymorphic_allocator<cpp17::byte> alloc;
     Pool<PNode> pool;
     PNode *root = nullptr;
     cpp17::pmr::vector<Postponed> postponed;
+    // Scratch space for assembling children of new nodes.
+    CompactVector<PNode *> stack;
     int newPostponed = 0;
     bool failed = false;
 };
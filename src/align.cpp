@@ -18,9 +18,12 @@
 
 #include <algorithm>
 #include <deque>
+#include <numeric>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/functional/hash.hpp>
 #include <boost/utility/string_ref.hpp>
 #include "dtl/dtl.hpp"
 
@@ -111,61 +114,286 @@ DiffSource::DiffSource(const Node &root)
     }
 }
 
-std::vector<DiffLine>
-makeDiff(DiffSource &&l, DiffSource &&r)
+namespace {
+
+// Pair of indexes of aligned lines.  -1 marks absence of a line on that side.
+struct AlignedLines
 {
-    using size_type = std::vector<std::string>::size_type;
+    int l;
+    int r;
+};
 
-    std::vector<LineInfo> &lt = l.lines;
-    std::vector<LineInfo> &rt = r.lines;
+// Aligns lines of two sources.  Lines that have the same set of matched nodes,
+// which doesn't occur anywhere else on either side, are aligned right away and
+// serve as anchors.  Only gaps between anchors are diffed with more expensive
+// comparison of lines.
+class Aligner
+{
+    using iterator = std::vector<const Node *>::const_iterator;
+
+    // Matched nodes of a line.
+    struct Fingerprint
+    {
+        iterator from;    // First non-null node.
+        iterator to;      // End of nodes.
+        std::size_t hash; // Hash of the nodes.
+    };
+
+public:
+    // Remembers lines and computes their fingerprints.
+    Aligner(std::vector<LineInfo> &lt, std::vector<LineInfo> &rt);
+
+public:
+    // Computes alignment of all lines.
+    std::vector<AlignedLines> align();
+
+private:
+    // Aligns [lFrom, lTo) lines with [rFrom, rTo) lines.
+    void alignRange(int lFrom, int lTo, int rFrom, int rTo);
+    // Finds the longest sequence of ordered anchors within the ranges.
+    std::vector<AlignedLines> findAnchors(int lFrom, int lTo,
+                                          int rFrom, int rTo) const;
+    // Aligns lines of the ranges by diffing them.
+    void diffRange(int lFrom, int lTo, int rFrom, int rTo);
+    // Checks whether two lines look similar enough to be aligned.
+    bool areSimilar(int i, int j);
+
+    // Computes fingerprint of a line.
+    static Fingerprint makeFingerprint(const std::vector<const Node *> &nodes);
 
+private:
+    std::vector<LineInfo> &lt;           // Lines of the left side.
+    std::vector<LineInfo> &rt;           // Lines of the right side.
+    std::vector<Fingerprint> lPrints;    // Relatives on the left side.
+    std::vector<Fingerprint> rPrints;    // Nodes on the right side.
+    std::vector<AlignedLines> alignment; // Result.
+};
+
+}
+
+// Gaps between anchors with fewer lines than this are diffed without looking
+// for anchors inside of them.
+static const int maxDirectDiffSize = 128;
+
+Aligner::Aligner(std::vector<LineInfo> &lt, std::vector<LineInfo> &rt)
+    : lt(lt), rt(rt)
+{
     for (LineInfo &info : lt) {
         std::sort(info.rels.begin(), info.rels.end());
+        lPrints.push_back(makeFingerprint(info.rels));
     }
     for (LineInfo &info : rt) {
         std::sort(info.nodes.begin(), info.nodes.end());
+        rPrints.push_back(makeFingerprint(info.nodes));
     }
+}
 
-    auto cmp = [](LineInfo &a, LineInfo &b) {
-        int all = a.rels.size() + b.nodes.size();
-        if (all == 0) {
-            // Match empty lines.
-            return true;
-        }
+Aligner::Fingerprint
+Aligner::makeFingerprint(const std::vector<const Node *> &nodes)
+{
+    // Null pointers go first after sorting.
+    const iterator from = std::find_if(nodes.cbegin(), nodes.cend(),
+                                       [](const Node *n) {
+                                           return (n != nullptr);
+                                       });
+    return { from, nodes.cend(), boost::hash_range(from, nodes.cend()) };
+}
+
+std::vector<AlignedLines>
+Aligner::align()
+{
+    alignment.clear();
+    alignRange(0, lt.size(), 0, rt.size());
+    return std::move(alignment);
+}
 
-        auto skipNulls = [](std::vector<const Node *> &v) {
-            return std::find_if(v.cbegin(), v.cend(), [](const Node *n) {
-                return (n != nullptr);
-            });
-        };
-
-        auto aRels = skipNulls(a.rels);
-        auto bRels = skipNulls(b.rels);
-        auto bNodes = skipNulls(b.nodes);
-
-        int matched = std::set_intersection(aRels, a.rels.cend(),
-                                            bNodes, b.nodes.cend(),
-                                            CountIterator()).getCount();
-        int total = (a.rels.cend() - aRels) + (b.nodes.cend() - bNodes);
-        // XXX: hard-coded thresholds.
-        return false
-            // Check for matched tokens first.
-            || (total != 0 && 2.0f*matched/total >= 0.6f)
-            // Check for complete replacement of tokens which look alike a bit.
-            || (matched == 0 &&
-                aRels == a.rels.cend() && bRels == b.rels.cend() &&
-                !a.nodes.empty() && !b.nodes.empty() &&
-                a.text.compare(b.text) >= 0.4f)
-            // Resort to text based comparison for small total number of tokens
-            // unless one of lines contains only removed/added tokens (first
-            // condition).
-            || ((aRels == a.rels.cend()) == (bRels == b.rels.cend()) &&
-                all > 2 && all < 7 && a.text.compare(b.text) >= 0.8f);
+void
+Aligner::alignRange(int lFrom, int lTo, int rFrom, int rTo)
+{
+    if (lFrom == lTo || rFrom == rTo ||
+        (lTo - lFrom) + (rTo - rFrom) < maxDirectDiffSize) {
+        return diffRange(lFrom, lTo, rFrom, rTo);
+    }
+
+    const std::vector<AlignedLines> anchors = findAnchors(lFrom, lTo,
+                                                          rFrom, rTo);
+    if (anchors.empty()) {
+        return diffRange(lFrom, lTo, rFrom, rTo);
+    }
+
+    for (const AlignedLines &anchor : anchors) {
+        alignRange(lFrom, anchor.l, rFrom, anchor.r);
+        alignment.push_back(anchor);
+        lFrom = anchor.l + 1;
+        rFrom = anchor.r + 1;
+    }
+    alignRange(lFrom, lTo, rFrom, rTo);
+}
+
+std::vector<AlignedLines>
+Aligner::findAnchors(int lFrom, int lTo, int rFrom, int rTo) const
+{
+    // Occurrences of a fingerprint within the ranges.
+    struct Occurrences
+    {
+        int lCount = 0;
+        int rCount = 0;
+        int l;
+        int r;
     };
 
-    dtl::Diff<LineInfo, std::vector<LineInfo>, decltype(cmp)> diff(lt, rt, cmp);
+    std::unordered_map<std::size_t, Occurrences> occurrences;
+    for (int i = lFrom; i < lTo; ++i) {
+        if (lPrints[i].from != lPrints[i].to) {
+            Occurrences &o = occurrences[lPrints[i].hash];
+            ++o.lCount;
+            o.l = i;
+        }
+    }
+    for (int j = rFrom; j < rTo; ++j) {
+        if (rPrints[j].from != rPrints[j].to) {
+            auto it = occurrences.find(rPrints[j].hash);
+            if (it != occurrences.end()) {
+                ++it->second.rCount;
+                it->second.r = j;
+            }
+        }
+    }
+
+    // Candidates in the order of left lines.
+    std::vector<AlignedLines> candidates;
+    for (int i = lFrom; i < lTo; ++i) {
+        if (lPrints[i].from == lPrints[i].to) {
+            continue;
+        }
+
+        const Occurrences &o = occurrences[lPrints[i].hash];
+        if (o.lCount != 1 || o.rCount != 1) {
+            continue;
+        }
+
+        const Fingerprint &a = lPrints[i];
+        const Fingerprint &b = rPrints[o.r];
+        if (a.to - a.from == b.to - b.from &&
+            std::equal(a.from, a.to, b.from)) {
+            candidates.push_back({ i, o.r });
+        }
+    }
+
+    // Longest increasing subsequence of right lines is the largest set of
+    // anchors that don't cross each other.
+    std::vector<int> tails;
+    std::vector<int> prev(candidates.size(), -1);
+    for (int k = 0; k < static_cast<int>(candidates.size()); ++k) {
+        auto pos = std::lower_bound(tails.begin(), tails.end(), k,
+                                    [&](int a, int b) {
+                                        return candidates[a].r
+                                             < candidates[b].r;
+                                    });
+        if (pos != tails.begin()) {
+            prev[k] = *(pos - 1);
+        }
+        if (pos == tails.end()) {
+            tails.push_back(k);
+        } else {
+            *pos = k;
+        }
+    }
+
+    std::vector<AlignedLines> anchors;
+    for (int k = tails.empty() ? -1 : tails.back(); k != -1; k = prev[k]) {
+        anchors.push_back(candidates[k]);
+    }
+    std::reverse(anchors.begin(), anchors.end());
+    return anchors;
+}
+
+void
+Aligner::diffRange(int lFrom, int lTo, int rFrom, int rTo)
+{
+    if (lFrom == lTo || rFrom == rTo) {
+        for (int i = lFrom; i < lTo; ++i) {
+            alignment.push_back({ i, -1 });
+        }
+        for (int j = rFrom; j < rTo; ++j) {
+            alignment.push_back({ -1, j });
+        }
+        return;
+    }
+
+    std::vector<int> a(lTo - lFrom), b(rTo - rFrom);
+    std::iota(a.begin(), a.end(), lFrom);
+    std::iota(b.begin(), b.end(), rFrom);
+
+    auto cmp = [this](int i, int j) { return areSimilar(i, j); };
+    dtl::Diff<int, std::vector<int>, decltype(cmp)> diff(a, b, cmp);
     diff.compose();
 
+    for (const auto &x : diff.getSes().getSequence()) {
+        switch (x.second.type) {
+            case dtl::SES_DELETE:
+                alignment.push_back({ x.first, -1 });
+                break;
+            case dtl::SES_ADD:
+                alignment.push_back({ -1, x.first });
+                break;
+            case dtl::SES_COMMON:
+                alignment.push_back({
+                    lFrom + static_cast<int>(x.second.beforeIdx) - 1,
+                    rFrom + static_cast<int>(x.second.afterIdx) - 1
+                });
+                break;
+        }
+    }
+}
+
+bool
+Aligner::areSimilar(int i, int j)
+{
+    LineInfo &a = lt[i];
+    LineInfo &b = rt[j];
+
+    int all = a.rels.size() + b.nodes.size();
+    if (all == 0) {
+        // Match empty lines.
+        return true;
+    }
+
+    const iterator aRels = lPrints[i].from;
+    const iterator bRels = std::find_if(b.rels.cbegin(), b.rels.cend(),
+                                        [](const Node *n) {
+                                            return (n != nullptr);
+                                        });
+    const iterator bNodes = rPrints[j].from;
+
+    int matched = std::set_intersection(aRels, a.rels.cend(),
+                                        bNodes, b.nodes.cend(),
+                                        CountIterator()).getCount();
+    int total = (a.rels.cend() - aRels) + (b.nodes.cend() - bNodes);
+    // XXX: hard-coded thresholds.
+    return false
+        // Check for matched tokens first.
+        || (total != 0 && 2.0f*matched/total >= 0.6f)
+        // Check for complete replacement of tokens which look alike a bit.
+        || (matched == 0 &&
+            aRels == a.rels.cend() && bRels == b.rels.cend() &&
+            !a.nodes.empty() && !b.nodes.empty() &&
+            a.text.compare(b.text) >= 0.4f)
+        // Resort to text based comparison for small total number of tokens
+        // unless one of lines contains only removed/added tokens (first
+        // condition).
+        || ((aRels == a.rels.cend()) == (bRels == b.rels.cend()) &&
+            all > 2 && all < 7 && a.text.compare(b.text) >= 0.8f);
+}
+
+std::vector<DiffLine>
+makeDiff(DiffSource &&l, DiffSource &&r)
+{
+    using size_type = std::vector<std::string>::size_type;
+
+    std::vector<LineInfo> &lt = l.lines;
+    std::vector<LineInfo> &rt = r.lines;
+
     size_type identicalLines = 0U;
     const size_type minFold = 3;
     const size_type ctxSize = 2;
@@ -197,19 +425,15 @@ makeDiff(DiffSource &&l, DiffSource &&r)
         }
     };
 
-    for (const auto &x : diff.getSes().getSequence()) {
-        switch (x.second.type) {
-            case dtl::SES_DELETE:
-                foldIdentical(false);
-                diffSeq.emplace_back(Diff::Left);
-                break;
-            case dtl::SES_ADD:
-                foldIdentical(false);
-                diffSeq.emplace_back(Diff::Right);
-                break;
-            case dtl::SES_COMMON:
-                handleSameLines(x.second.beforeIdx - 1, x.second.afterIdx - 1);
-                break;
+    for (const AlignedLines &x : Aligner(lt, rt).align()) {
+        if (x.r == -1) {
+            foldIdentical(false);
+            diffSeq.emplace_back(Diff::Left);
+        } else if (x.l == -1) {
+            foldIdentical(false);
+            diffSeq.emplace_back(Diff::Right);
+        } else {
+            handleSameLines(x.l, x.r);
         }
     }
 
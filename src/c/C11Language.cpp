@@ -158,6 +158,18 @@ C11Language::parse(const std::string &contents, const std::string &fileName,
     return c11_parse(contents, fileName, debug, mr);
 }
 
+TreeBuilder
+C11Language::reparse(const std::string &contents, const std::string &fileName,
+                     bool debug, ParseCache &cache,
+                     cpp17::pmr::monolithic &mr) const
+{
+    // Debug output is produced only by parsing everything.
+    if (debug) {
+        return c11_parse(contents, fileName, debug, mr);
+    }
+    return c11_reparse(contents, fileName, cache, mr);
+}
+
 bool
 C11Language::isTravellingNode(const Node *x) const
 {
@@ -36,6 +36,13 @@ public:
                               const std::string &fileName,
                               bool debug,
                               cpp17::pmr::monolithic &mr) const override;
+    // Parses source file into a tree reparsing only pieces of it that aren't
+    // in the cache.
+    virtual TreeBuilder reparse(const std::string &contents,
+                                const std::string &fileName,
+                                bool debug,
+                                ParseCache &cache,
+                                cpp17::pmr::monolithic &mr) const override;
 
     // Checks whether node doesn't have fixed position within a tree and can
     // move between internal nodes as long as post-order of leafs is preserved.
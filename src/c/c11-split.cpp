@@ -0,0 +1,189 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "c/c11-split.hpp"
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+static std::size_t skipMlComment(const std::string &s, std::size_t i,
+                                 int &line);
+static std::size_t skipLiteral(const std::string &s, std::size_t i, int &line);
+static std::size_t skipDirective(const std::string &s, std::size_t i,
+                                 int &line);
+
+std::vector<C11SplitPoint>
+c11_split(const std::string &contents, std::size_t nChunks)
+{
+    std::vector<C11SplitPoint> points;
+    if (nChunks < 2U) {
+        return points;
+    }
+
+    const std::size_t size = contents.size();
+    const std::size_t chunkSize = size/nChunks;
+    std::size_t nextSplit = chunkSize;
+
+    int line = 1;
+    int braces = 0;
+    int parens = 0;
+    // Only whitespace was seen on current line so far.
+    bool lineStart = true;
+    // Top-level declaration ended and only whitespace followed it.
+    bool declEnd = false;
+    // Current top-level pair of braces delimits body of a function.
+    bool funcBody = false;
+    // Last character that isn't part of whitespace or a comment.
+    char last = '\0';
+
+    for (std::size_t i = 0U; i < size; ++i) {
+        const char c = contents[i];
+
+        if (c == '\n') {
+            ++line;
+            if (declEnd && i + 1U >= nextSplit && i + 1U < size) {
+                points.push_back({ i + 1U, line });
+                if (points.size() == nChunks - 1U) {
+                    break;
+                }
+                nextSplit = i + 1U + chunkSize;
+            }
+            declEnd = false;
+            lineStart = true;
+            continue;
+        }
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            continue;
+        }
+
+        declEnd = false;
+
+        if (c == '#' && lineStart) {
+            i = skipDirective(contents, i, line);
+            continue;
+        }
+        lineStart = false;
+
+        if (c == '/' && i + 1U < size && contents[i + 1U] == '*') {
+            i = skipMlComment(contents, i + 2U, line);
+            continue;
+        }
+        if (c == '/' && i + 1U < size && contents[i + 1U] == '/') {
+            while (i + 1U < size && contents[i + 1U] != '\n') {
+                ++i;
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '"':
+            case '\'':
+                i = skipLiteral(contents, i, line);
+                break;
+            case '(':
+            case '[':
+                ++parens;
+                break;
+            case ')':
+            case ']':
+                --parens;
+                break;
+            case '{':
+                if (braces == 0) {
+                    funcBody = (last == ')');
+                }
+                ++braces;
+                break;
+            case '}':
+                if (--braces == 0) {
+                    declEnd = (parens == 0 && funcBody);
+                }
+                break;
+            case ';':
+                declEnd = (braces == 0 && parens == 0);
+                break;
+        }
+        last = c;
+
+        if (braces < 0 || parens < 0) {
+            // Something we don't understand, better not to split at all.
+            return {};
+        }
+    }
+
+    return points;
+}
+
+// Skips multiline comment which starts right before the `i` position.  Returns
+// position of the last character of the comment.
+static std::size_t
+skipMlComment(const std::string &s, std::size_t i, int &line)
+{
+    for (; i < s.size(); ++i) {
+        if (s[i] == '\n') {
+            ++line;
+        } else if (s[i] == '*' && i + 1U < s.size() && s[i + 1U] == '/') {
+            return i + 1U;
+        }
+    }
+    return s.size() - 1U;
+}
+
+// Skips string or character literal that starts at the `i` position.  Returns
+// position of its closing quote or of the last character before unescaped end
+// of line.
+static std::size_t
+skipLiteral(const std::string &s, std::size_t i, int &line)
+{
+    const char quote = s[i];
+    for (++i; i < s.size(); ++i) {
+        if (s[i] == '\\' && i + 1U < s.size()) {
+            if (s[++i] == '\n') {
+                ++line;
+            }
+        } else if (s[i] == quote) {
+            return i;
+        } else if (s[i] == '\n') {
+            return i - 1U;
+        }
+    }
+    return s.size() - 1U;
+}
+
+// Skips preprocessor directive that starts at the `i` position the same way
+// lexer does it.  Returns position of the last character before its end of
+// line.
+static std::size_t
+skipDirective(const std::string &s, std::size_t i, int &line)
+{
+    for (++i; i < s.size(); ++i) {
+        if (s[i] == '\\' && s.compare(i + 1U, 1U, "\n") == 0) {
+            ++line;
+            ++i;
+        } else if (s[i] == '\\' && s.compare(i + 1U, 2U, "\r\n") == 0) {
+            ++line;
+            i += 2U;
+        } else if (s[i] == '/' && i + 1U < s.size() && s[i + 1U] == '*') {
+            i = skipMlComment(s, i + 2U, line);
+        } else if (s[i] == '\n') {
+            return i - 1U;
+        }
+    }
+    return s.size() - 1U;
+}
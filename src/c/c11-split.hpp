@@ -0,0 +1,42 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__C__C11_SPLIT_HPP__
+#define ZOGRASCOPE__C__C11_SPLIT_HPP__
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+// Place at which C source can be cut in two parts that can be parsed
+// independently of each other.
+struct C11SplitPoint
+{
+    std::size_t offset; // Offset of the first character of a line.
+    int line;           // Number of that line (starting with 1).
+};
+
+// Finds at most `nChunks - 1` split points that cut source into pieces of
+// roughly equal size.  Source is cut only at the beginning of a line that
+// follows a line ending with a top-level declaration (`;` or closing brace of
+// a function body followed by nothing but whitespace), so that no token,
+// comment or directive ends up being shared by two pieces.  Returns empty list
+// if source can't be split.
+std::vector<C11SplitPoint> c11_split(const std::string &contents,
+                                     std::size_t nChunks);
+
+#endif // ZOGRASCOPE__C__C11_SPLIT_HPP__
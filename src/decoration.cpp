@@ -20,7 +20,11 @@
 
 #include <cstdio>
 
+#include <atomic>
 #include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
 
 #include <boost/variant.hpp>
 
@@ -84,7 +88,7 @@ private:
     /**
      * @brief Whether outputting of ASCII escape sequences is enabled.
      */
-    bool isAscii = isatty(fileno(stdout));
+    std::atomic<bool> isAscii { isatty(fileno(stdout)) != 0 };
 } C;
 
 }
@@ -242,6 +246,25 @@ ScopedDecoration::decorate(std::ostream &os) const
     return os;
 }
 
+std::pair<std::string, std::string>
+decor::precompile(const Decoration &d)
+{
+    std::ostringstream opening, closing;
+    if (!d.isEmpty()) {
+        opening << d;
+        if (!C.isOn()) {
+            if (const Decoration *pfx = d.getPrefix()) {
+                opening << *pfx;
+            }
+            if (const Decoration *sfx = d.getSuffix()) {
+                closing << *sfx;
+            }
+        }
+        closing << def;
+    }
+    return { opening.str(), closing.str() };
+}
+
 void
 decor::enableDecorations()
 {
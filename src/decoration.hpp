@@ -20,7 +20,9 @@
 #include <functional>
 #include <iosfwd>
 #include <memory>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <boost/variant.hpp>
@@ -352,6 +354,17 @@ operator<<(std::ostream &os, const ScopedDecoration &sd)
     return sd.decorate(os);
 }
 
+/**
+ * @brief Prints what scoped decoration outputs around its data.
+ *
+ * Result reflects state of decorations at the moment of the call.
+ *
+ * @param d Decoration to print.
+ *
+ * @returns Pair of strings that precede and follow decorated data.
+ */
+std::pair<std::string, std::string> precompile(const Decoration &d);
+
 /**
  * @{
  * @name Generic attributes
@@ -19,6 +19,10 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -27,12 +31,18 @@
 #include <boost/iostreams/stream_buffer.hpp>
 #include <boost/scope_exit.hpp>
 
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
 
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -102,14 +112,6 @@ public:
         std::streamsize write(const char s[], std::streamsize n);
 
     private:
-        /**
-         * @brief Writes single character.
-         *
-         * @param c Character to write.
-         *
-         * @returns @c true on success, @c false otherwise.
-         */
-        bool put(char c);
         /**
          * @brief Opens pager for output.
          */
@@ -186,39 +188,41 @@ ScreenPageBuffer::~ScreenPageBuffer()
 
 std::streamsize
 ScreenPageBuffer::write(const char s[], std::streamsize n)
-{
-    for (std::streamsize i = 0U; i < n; ++i) {
-        if (!put(s[i])) {
-            return i;
-        }
-    }
-    return n;
-}
-
-bool
-ScreenPageBuffer::put(char c)
 {
     if (redirectToPager) {
-        return boost::iostreams::put(*out, c);
+        return out->sputn(s, n);
     }
 
-    if (c == '\n') {
-        ++nLines;
-    }
+    // Look for the first new line that doesn't fit on the screen.
+    const char *const end = s + n;
+    const char *overflow = s;
+    while (overflow != end) {
+        const void *nl = std::memchr(overflow, '\n', end - overflow);
+        if (nl == nullptr) {
+            overflow = end;
+            break;
+        }
 
-    if (nLines > screenHeight) {
-        openPager();
-        redirectToPager = true;
-        for (char c : buffer) {
-            if (!boost::iostreams::put(*out, c)) {
-                return false;
-            }
+        overflow = static_cast<const char *>(nl);
+        if (++nLines > screenHeight) {
+            break;
         }
-        return boost::iostreams::put(*out, c);
+        ++overflow;
     }
 
-    buffer.push_back(c);
-    return true;
+    buffer.append(s, overflow);
+    if (overflow == end) {
+        return n;
+    }
+
+    openPager();
+    redirectToPager = true;
+
+    const std::streamsize size = buffer.size();
+    if (out->sputn(buffer.data(), size) != size) {
+        return overflow - s;
+    }
+    return (overflow - s) + out->sputn(overflow, end - overflow);
 }
 
 void
@@ -286,22 +290,128 @@ getTerminalSize()
     return { ws.ws_col, ws.ws_row };
 }
 
-std::string
-readCommandOutput(std::vector<std::string> cmd, const std::string &input)
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+#  define HAVE_PIPE2
+#else
+// Serializes creation of pipes with forking, otherwise a process forked by
+// another thread between pipe() and fcntl() inherits the pipe and keeps it
+// open.
+static std::mutex pipeForkMutex;
+#endif
+
+// Creates a pipe whose ends are closed in child processes on exec.
+static bool
+makePipe(int pipePair[2])
+{
+#ifdef HAVE_PIPE2
+    return (pipe2(pipePair, O_CLOEXEC) == 0);
+#else
+    std::lock_guard<std::mutex> lock(pipeForkMutex);
+    if (pipe(pipePair) != 0) {
+        return false;
+    }
+    fcntl(pipePair[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipePair[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+// Sends input to a command while reading its output, so that neither side
+// blocks on a full pipe.  SIGPIPE is suppressed for the duration of the call,
+// so that a command which exits without reading all of its input results in
+// an error instead of termination.  Closes both file descriptors.
+static void
+communicate(int inFd, int outFd, const std::string &input,
+            const std::function<void(const char[], std::size_t)> &consumer)
+{
+    sigset_t pipeSet, oldSet, pendingSet;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+    sigpending(&pendingSet);
+    const bool wasPending = sigismember(&pendingSet, SIGPIPE);
+
+    BOOST_SCOPE_EXIT_ALL(&inFd, outFd, &pipeSet, &oldSet, wasPending) {
+        if (inFd != -1) {
+            close(inFd);
+        }
+        close(outFd);
+
+        sigset_t pendingSet;
+        sigpending(&pendingSet);
+        if (!wasPending && sigismember(&pendingSet, SIGPIPE)) {
+            // Consume SIGPIPE generated by this thread.
+            timespec noWait = {};
+            sigtimedwait(&pipeSet, nullptr, &noWait);
+        }
+        pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+    };
+
+    const char *ptr = input.data();
+    std::size_t left = input.size();
+    if (left == 0U) {
+        close(inFd);
+        inFd = -1;
+    } else {
+        fcntl(inFd, F_SETFL, fcntl(inFd, F_GETFL) | O_NONBLOCK);
+    }
+
+    char buf[16*1024];
+    while (true) {
+        pollfd fds[2] = { { outFd, POLLIN, 0 }, { inFd, POLLOUT, 0 } };
+        if (poll(fds, (inFd == -1 ? 1U : 2U), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (inFd != -1 && fds[1].revents != 0) {
+            const ssize_t written = write(inFd, ptr, left);
+            if (written > 0) {
+                ptr += written;
+                left -= written;
+            }
+            if (left == 0U || (written == -1 && errno != EAGAIN &&
+                               errno != EINTR)) {
+                close(inFd);
+                inFd = -1;
+            }
+        }
+
+        if (fds[0].revents != 0) {
+            const ssize_t nread = read(outFd, buf, sizeof(buf));
+            if (nread > 0) {
+                consumer(buf, nread);
+            } else if (nread == 0 || errno != EINTR) {
+                break;
+            }
+        }
+    }
+}
+
+PendingCommand::PendingCommand(std::vector<std::string> cmd)
+    : name(cmd.at(0)), pid(-1), inFd(-1), outFd(-1)
 {
     int stdinPipePair[2];
-    if (pipe(stdinPipePair) != 0) {
+    if (!makePipe(stdinPipePair)) {
         throw std::runtime_error("Failed to create a pipe");
     }
 
     int stdoutPipePair[2];
-    if (pipe(stdoutPipePair) != 0) {
+    if (!makePipe(stdoutPipePair)) {
         close(stdinPipePair[0]);
         close(stdinPipePair[1]);
         throw std::runtime_error("Failed to create a pipe");
     }
 
-    pid_t pid = fork();
+    {
+#ifndef HAVE_PIPE2
+        std::lock_guard<std::mutex> lock(pipeForkMutex);
+#endif
+        pid = fork();
+    }
     if (pid == -1) {
         close(stdinPipePair[0]);
         close(stdinPipePair[1]);
@@ -334,22 +444,69 @@ readCommandOutput(std::vector<std::string> cmd, const std::string &input)
     close(stdinPipePair[0]);
     close(stdoutPipePair[1]);
 
-    io::stream<io::file_descriptor_sink>
-        stdinStream(stdinPipePair[1], boost::iostreams::close_handle);
-    stdinStream << input;
-    stdinStream.close();
+    inFd = stdinPipePair[1];
+    outFd = stdoutPipePair[0];
+}
 
-    io::stream_buffer<io::file_descriptor_source>
-        stdoutStream(stdoutPipePair[0], boost::iostreams::close_handle);
+PendingCommand::PendingCommand(PendingCommand &&rhs)
+    : name(std::move(rhs.name)), pid(rhs.pid), inFd(rhs.inFd),
+      outFd(rhs.outFd)
+{
+    rhs.pid = -1;
+    rhs.inFd = -1;
+    rhs.outFd = -1;
+}
 
-    std::ostringstream iss;
-    iss << &stdoutStream;
+PendingCommand::~PendingCommand()
+{
+    if (inFd != -1) {
+        close(inFd);
+    }
+    if (outFd != -1) {
+        close(outFd);
+    }
+    if (pid != -1) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+std::string
+PendingCommand::run(const std::string &input)
+{
+    std::string output;
+    run(input, [&output](const char data[], std::size_t size) {
+        output.append(data, size);
+    });
+    return normalizeEols(std::move(output));
+}
+
+void
+PendingCommand::run(const std::string &input,
+                 const std::function<void(const char[], std::size_t)> &consumer)
+{
+    if (pid == -1) {
+        throw std::logic_error("Command was already run: " + name);
+    }
+
+    const int in = inFd, out = outFd;
+    inFd = -1;
+    outFd = -1;
+    // Failure to communicate is reported below as failed invocation.
+    communicate(in, out, input, consumer);
 
     int wstatus;
-    if (waitpid(pid, &wstatus, 0) == -1 || !WIFEXITED(wstatus) ||
+    const bool failed = (waitpid(pid, &wstatus, 0) == -1);
+    pid = -1;
+
+    if (failed || !WIFEXITED(wstatus) ||
         WEXITSTATUS(wstatus) != EXIT_SUCCESS) {
-        throw std::runtime_error("Invocation failed for " + cmd[0]);
+        throw std::runtime_error("Invocation failed for " + name);
     }
+}
 
-    return normalizeEols(iss.str());
+std::string
+readCommandOutput(std::vector<std::string> cmd, const std::string &input)
+{
+    return PendingCommand(std::move(cmd)).run(input);
 }
@@ -17,6 +17,9 @@
 #ifndef ZOGRASCOPE__INTEGRATION_HPP__
 #define ZOGRASCOPE__INTEGRATION_HPP__
 
+#include <cstddef>
+
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -80,6 +83,79 @@ bool isOutputToTerminal();
  */
 std::pair<unsigned int, unsigned int> getTerminalSize();
 
+/**
+ * @brief Command which is started before its input is known.
+ *
+ * Starting a process ahead of time allows its initialization to overlap with
+ * other work.  Pipes of the command are not inherited by other commands.
+ */
+class PendingCommand
+{
+public:
+    /**
+     * @brief Starts the command which then waits for input.
+     *
+     * @note The parameter is taken by value to avoid casting away constness.
+     *
+     * @param cmd Program name followed by its arguments.
+     *
+     * @throws std::runtime_error On failure to start the command.
+     */
+    explicit PendingCommand(std::vector<std::string> cmd);
+
+    //! No copy-constructor.
+    PendingCommand(const PendingCommand &rhs) = delete;
+    //! Moves the process out of @p rhs.
+    PendingCommand(PendingCommand &&rhs);
+    //! No copy-assignment.
+    PendingCommand & operator=(const PendingCommand &rhs) = delete;
+    //! No move-assignment.
+    PendingCommand & operator=(PendingCommand &&rhs) = delete;
+
+    /**
+     * @brief Terminates the command if it wasn't run.
+     */
+    ~PendingCommand();
+
+public:
+    /**
+     * @brief Feeds input to the command and captures its output.
+     *
+     * Can be called only once.
+     *
+     * @param input Input to be sent to program's standard input stream.
+     *
+     * @throws std::runtime_error On errors (including application returning
+     *                            non-0).
+     */
+    std::string run(const std::string &input);
+
+    /**
+     * @brief Feeds input to the command and hands its output to a function as
+     *        it arrives.
+     *
+     * Can be called only once.  Line endings of the output are left intact.
+     *
+     * @param input Input to be sent to program's standard input stream.
+     * @param consumer Receiver of pieces of output.
+     *
+     * @throws std::runtime_error On errors (including application returning
+     *                            non-0).
+     */
+    void run(const std::string &input,
+             const std::function<void(const char[], std::size_t)> &consumer);
+
+private:
+    //! Name of the program.
+    std::string name;
+    //! Process ID of the command or @c -1.
+    int pid;
+    //! Write end of a pipe connected to standard input of the command.
+    int inFd;
+    //! Read end of a pipe connected to standard output of the command.
+    int outFd;
+};
+
 /**
  * @brief Runs a command and captures its output.
  *
@@ -18,21 +18,26 @@
 
 #include <cstdlib>
 
+#include <functional>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/utility/string_ref.hpp>
-#include "tinyxml2/tinyxml2.h"
 
+#include "srcml/XmlTokenizer.hpp"
 #include "TreeBuilder.hpp"
 #include "integration.hpp"
 #include "types.hpp"
 
-namespace ti = tinyxml2;
-
 // XXX: hard-coded width of a tabulation character.
 const int tabWidth = 4;
 
@@ -82,10 +87,90 @@ private:
     std::string path; // Path to the temporary file.
 };
 
+// Keeps one srcml process for a particular language started ahead of time, so
+// that its startup overlaps with processing of previous file.  Each process
+// converts only one unit, because srcml reads its input until EOF.
+class SrcmlWorkers
+{
+public:
+    // Remembers language for future invocations.
+    explicit SrcmlWorkers(std::string language) : language(std::move(language))
+    { }
+
+public:
+    // Converts source code into srcML passing it to the consumer in pieces.
+    // Throws `std::runtime_error` on failure.
+    void convert(const std::string &contents,
+                 const std::function<void(const char[], std::size_t)> &consumer)
+    {
+        take().run(contents, consumer);
+    }
+
+private:
+    // Retrieves a started process (starting it if there is none) and starts a
+    // spare one in its place.  Processes are started outside of the lock.
+    PendingCommand take()
+    {
+        std::unique_ptr<PendingCommand> worker;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            worker = std::move(spare);
+        }
+
+        if (worker == nullptr) {
+            worker.reset(new PendingCommand(makeCmd()));
+        }
+
+        std::unique_ptr<PendingCommand> next(new PendingCommand(makeCmd()));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (spare == nullptr) {
+                spare = std::move(next);
+            }
+        }
+
+        return std::move(*worker);
+    }
+
+    // Builds command that reads source from standard input.
+    std::vector<std::string> makeCmd() const
+    {
+        return { "srcml", "--language=" + language, "--src-encoding=utf8" };
+    }
+
+private:
+    const std::string language;            // Language of the input.
+    std::mutex mutex;                      // Protects `spare` field.
+    std::unique_ptr<PendingCommand> spare; // Process waiting for input.
+};
+
+}
+
+// Retrieves workers for the specified language.
+static SrcmlWorkers &
+getWorkers(const std::string &language)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string,
+                              std::unique_ptr<SrcmlWorkers>> workers;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<SrcmlWorkers> &w = workers[language];
+    if (w == nullptr) {
+        w.reset(new SrcmlWorkers(language));
+    }
+    return *w;
 }
 
 static boost::string_ref processValue(boost::string_ref str);
 static void updatePosition(boost::string_ref str, int &line, int &col);
+static Type getLiteralType(boost::string_ref type);
+
+std::size_t
+SrcmlTransformer::Hash::operator()(boost::string_ref str) const
+{
+    return boost::hash_range(str.begin(), str.end());
+}
 
 SrcmlTransformer::SrcmlTransformer(const std::string &contents,
                                    const std::string &path, TreeBuilder &tb,
@@ -93,11 +178,65 @@ SrcmlTransformer::SrcmlTransformer(const std::string &contents,
                               const std::unordered_map<std::string, SType> &map,
                                 const std::unordered_set<std::string> &keywords)
     : contents(contents), path(path), tb(tb), language(language),
-      map(map), keywords(keywords)
-{ }
+      map(map), keywords(keywords), separator()
+{
+    // Names are resolved via this table to not compare or copy strings for
+    // every element.  Keys refer to strings of the map or to literals.
+    for (const auto &entry : map) {
+        tags.emplace(entry.first,
+                     TagInfo { entry.second, Tag::Other,
+                               boost::starts_with(entry.first, "cpp:") });
+    }
+
+    static const std::pair<const char *, Tag> specialTags[] = {
+        { "literal", Tag::Literal },   { "specifier", Tag::Specifier },
+        { "comment", Tag::Comment },   { "operator", Tag::Operator },
+        { "name", Tag::Name },         { "type", Tag::Type },
+        { "function", Tag::Function }, { "call", Tag::Call },
+    };
+    for (const auto &special : specialTags) {
+        auto it = tags.emplace(special.first,
+                               TagInfo { SType{}, Tag::Other, false }).first;
+        it->second.tag = special.second;
+    }
+
+    auto it = map.find("separator");
+    if (it != map.end()) {
+        separator = it->second;
+    }
+}
 
 void
 SrcmlTransformer::transform()
+{
+    if (!stream()) {
+        // Fall back to slower, but more reliable way of invoking srcml.
+        invokeSrcml();
+    }
+
+    tb.setRoot(root == nullptr ? tb.addNode() : root);
+}
+
+bool
+SrcmlTransformer::stream()
+{
+    reset();
+
+    XmlTokenizer tokenizer(*this);
+    try {
+        getWorkers(language).convert(contents,
+                                     [&](const char data[], std::size_t size) {
+            tokenizer.feed(boost::string_ref(data, size));
+        });
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+
+    return tokenizer.finish() && root != nullptr;
+}
+
+void
+SrcmlTransformer::invokeSrcml()
 {
     TempFile tmpFile(path);
 
@@ -113,76 +252,137 @@ SrcmlTransformer::transform()
         "srcml", "--language=" + language, "--src-encoding=utf8", tmpFile
     };
 
-    std::string xml = readCommandOutput(cmd, std::string());
-
-    ti::XMLDocument doc;
-    if (doc.Parse(xml.data(), xml.size()) == ti::XML_SUCCESS &&
-        doc.RootElement() == nullptr) {
-
+    if (!parse(readCommandOutput(cmd, std::string()))) {
         // Work around srcml's issues with parsing files.  Sometimes it can't
         // read them from file (when extension is ".z" it thinks it's an
         // archive) and sometimes from stdin (bugs of previous versions), so try
         // both ways.
         cmd.pop_back();
-        xml = readCommandOutput(cmd, contents);
-        doc.Parse(xml.data(), xml.size());
+        parse(readCommandOutput(cmd, contents));
     }
+}
+
+bool
+SrcmlTransformer::parse(const std::string &xml)
+{
+    reset();
 
-    if (doc.Error()) {
-        throw std::runtime_error("Failed to parse: " +
-                                 std::string(doc.ErrorStr()));
+    XmlTokenizer tokenizer(*this);
+    if (!tokenizer.feed(xml) || !tokenizer.finish()) {
+        throw std::runtime_error("Failed to parse: " + tokenizer.getError());
     }
 
+    return (root != nullptr);
+}
+
+void
+SrcmlTransformer::reset()
+{
     left = contents;
     line = 1;
     col = 1;
     inCppDirective = 0;
 
-    tb.setRoot(visit(doc.RootElement(), 0));
+    root = nullptr;
+    stack.clear();
+    ignored = 0;
+    hasPendingText = false;
 }
 
-PNode *
-SrcmlTransformer::visit(ti::XMLNode *node, int level)
+void
+SrcmlTransformer::startElement(boost::string_ref name,
+                               const std::vector<XmlAttr> &attrs)
 {
-    if (node == nullptr) {
-        return tb.addNode();
+    // Only the first top-level element is transformed.
+    if (ignored != 0 || (stack.empty() && root != nullptr)) {
+        ++ignored;
+        return;
     }
 
-    SType stype = {};
-    auto it = map.find(node->Value());
-    if (it != map.end()) {
-        stype = it->second;
+    flushText(false);
+
+    TagInfo info = { SType{}, Tag::Other, boost::starts_with(name, "cpp:") };
+    auto it = tags.find(name);
+    if (it != tags.end()) {
+        info = it->second;
+    }
+
+    Element elem;
+    elem.pnode = tb.addNode({}, info.stype);
+    elem.tag = info.tag;
+    elem.literalType = Type::Other;
+    elem.cppDirective = info.cppDirective;
+    elem.firstChild = (stack.empty() || stack.back().nChildren == 0);
+    elem.nChildren = 0;
+
+    if (elem.tag == Tag::Literal) {
+        for (const XmlAttr &attr : attrs) {
+            if (attr.name == "type") {
+                elem.literalType = getLiteralType(attr.value);
+            }
+        }
     }
 
-    bool cppDirective = boost::starts_with(node->Value(), "cpp:");
-    inCppDirective += cppDirective;
+    if (stack.empty()) {
+        root = elem.pnode;
+    } else {
+        ++stack.back().nChildren;
+    }
 
-    PNode *pnode = tb.addNode({}, stype);
+    inCppDirective += elem.cppDirective;
+    stack.push_back(elem);
+}
 
-    for (ti::XMLNode *child = node->FirstChild();
-         child != nullptr;
-         child = child->NextSibling()) {
-        if (ti::XMLElement *e = child->ToElement()) {
-            tb.append(pnode, visit(e, level + 1));
-        } else if (child->ToText() != nullptr) {
-            visitLeaf(node, pnode, child);
-        }
+void
+SrcmlTransformer::endElement()
+{
+    if (ignored != 0) {
+        --ignored;
+        return;
+    }
+
+    flushText(true);
+
+    const Element elem = stack.back();
+    stack.pop_back();
+    inCppDirective -= elem.cppDirective;
+
+    if (!stack.empty()) {
+        tb.append(stack.back().pnode, elem.pnode);
+    }
+}
+
+void
+SrcmlTransformer::text(boost::string_ref text)
+{
+    if (ignored != 0 || stack.empty()) {
+        return;
     }
 
-    inCppDirective -= cppDirective;
+    flushText(false);
 
-    return pnode;
+    pendingText.assign(text.begin(), text.end());
+    hasPendingText = true;
+    pendingFirst = (stack.back().nChildren++ == 0);
 }
 
 void
-SrcmlTransformer::visitLeaf(ti::XMLNode *parent, PNode *pnode,
-                            ti::XMLNode *leaf)
+SrcmlTransformer::flushText(bool atEnd)
 {
-    boost::string_ref fullVal = processValue(leaf->Value());
+    if (hasPendingText) {
+        hasPendingText = false;
+        visitLeaf(pendingText, pendingFirst && atEnd);
+    }
+}
+
+void
+SrcmlTransformer::visitLeaf(boost::string_ref text, bool onlyChild)
+{
+    boost::string_ref fullVal = processValue(text);
 
     SType stype = {};
-    if (leaf != parent->FirstChild() || leaf->NextSibling() != nullptr) {
-        stype = map.at("separator");
+    if (!onlyChild) {
+        stype = separator;
     }
 
     std::vector<boost::string_ref> vals = { fullVal };
@@ -194,12 +394,13 @@ SrcmlTransformer::visitLeaf(ti::XMLNode *parent, PNode *pnode,
         };
     }
 
+    PNode *pnode = stack.back().pnode;
     for (boost::string_ref val : vals) {
         const std::size_t skipped = left.find(val);
         updatePosition(left.substr(0U, skipped), line, col);
         left.remove_prefix(skipped);
 
-        const Type type = determineType(parent->ToElement(), val);
+        const Type type = determineType(val);
 
         const auto offset = static_cast<std::uint32_t>(&left[0] - &contents[0]);
         const auto len = static_cast<std::uint32_t>(val.size());
@@ -252,27 +453,14 @@ updatePosition(boost::string_ref str, int &line, int &col)
 }
 
 Type
-SrcmlTransformer::determineType(ti::XMLElement *elem, boost::string_ref value)
+SrcmlTransformer::determineType(boost::string_ref value) const
 {
-    boost::string_ref elemValue = elem->Value();
-    if (elemValue == "literal") {
-        const std::string type = elem->Attribute("type");
-        if (type == "boolean") {
-            return Type::IntConstants;
-        } else if (type == "char") {
-            return Type::CharConstants;
-        } else if (type == "null") {
-            return Type::IntConstants;
-        } else if (type == "number") {
-            return Type::IntConstants;
-        } else if (type == "string") {
-            return Type::StrConstants;
-        } else if (type == "complex") {
-            return Type::FPConstants;
-        }
-    } else if (elemValue == "specifier") {
+    const Element &elem = stack.back();
+    if (elem.tag == Tag::Literal) {
+        return elem.literalType;
+    } else if (elem.tag == Tag::Specifier) {
         return Type::Specifiers;
-    } else if (elemValue == "comment") {
+    } else if (elem.tag == Tag::Comment) {
         return Type::Comments;
     } else if (inCppDirective) {
         return Type::Directives;
@@ -280,30 +468,34 @@ SrcmlTransformer::determineType(ti::XMLElement *elem, boost::string_ref value)
         return Type::LeftBrackets;
     } else if (value[0] == ')' || value[0] == '}' || value[0] == ']') {
         return Type::RightBrackets;
-    } else if (elemValue == "operator") {
+    } else if (elem.tag == Tag::Operator) {
         return Type::Operators;
-    } else if (elemValue == "name") {
-        const ti::XMLNode *parent = elem;
-        std::string parentValue;
-        std::string grandParentValue;
-        do {
-            parent = parent->Parent();
-            parentValue = (parent == nullptr ? "" : parent->Value());
-            grandParentValue = (parent->Parent() == nullptr)
-                             ? ""
-                             : parent->Parent()->Value();
-        } while (parentValue == "name" &&
-                 (elem != parent->FirstChild() ||
-                  (grandParentValue != "function" &&
-                   grandParentValue != "call")));
+    } else if (elem.tag == Tag::Name) {
+        // Skip enclosing names unless this is the first part of a name of a
+        // function or a call.
+        Tag parentTag = Tag::Other;
+        std::size_t i = stack.size() - 1U;
+        while (i != 0U) {
+            --i;
+            parentTag = stack[i].tag;
+            const Tag grandParentTag = (i == 0U ? Tag::Other
+                                                : stack[i - 1U].tag);
+            const bool isFirstChild = (i == stack.size() - 2U &&
+                                       elem.firstChild);
+            if (parentTag != Tag::Name ||
+                (isFirstChild && (grandParentTag == Tag::Function ||
+                                  grandParentTag == Tag::Call))) {
+                break;
+            }
+        }
 
         if (keywords.find(value.to_string()) != keywords.cend()) {
             return Type::Keywords;
         }
-        if (parentValue == "type") {
+        if (parentTag == Tag::Type) {
             return Type::UserTypes;
         }
-        if (parentValue == "function" || parentValue == "call") {
+        if (parentTag == Tag::Function || parentTag == Tag::Call) {
             return Type::Functions;
         }
         return Type::Identifiers;
@@ -312,3 +504,23 @@ SrcmlTransformer::determineType(ti::XMLElement *elem, boost::string_ref value)
     }
     return Type::Other;
 }
+
+// Maps value of type attribute of a literal to a type.
+static Type
+getLiteralType(boost::string_ref type)
+{
+    if (type == "boolean") {
+        return Type::IntConstants;
+    } else if (type == "char") {
+        return Type::CharConstants;
+    } else if (type == "null") {
+        return Type::IntConstants;
+    } else if (type == "number") {
+        return Type::IntConstants;
+    } else if (type == "string") {
+        return Type::StrConstants;
+    } else if (type == "complex") {
+        return Type::FPConstants;
+    }
+    return Type::Other;
+}
@@ -14,19 +14,21 @@
 // You should have received a copy of the GNU Affero General Public License
 // along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
 
+
 #ifndef ZOGRASCOPE__SRCML__SRCMLTRANSFORMER_HPP__
 #define ZOGRASCOPE__SRCML__SRCMLTRANSFORMER_HPP__
 
+#include <cstddef>
+#include <cstdint>
+
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/utility/string_ref.hpp>
 
-namespace tinyxml2 {
-    class XMLElement;
-    class XMLNode;
-}
+#include "srcml/XmlTokenizer.hpp"
 
 class PNode;
 class TreeBuilder;
@@ -34,9 +36,41 @@ class TreeBuilder;
 enum class SType : std::uint8_t;
 enum class Type : std::uint8_t;
 
-// Uses srcml to parse a file and transforms the result into PTree.
-class SrcmlTransformer
+// Builds parse tree out of srcML produced by srcml tool.  The output is
+// processed as it's being read instead of being stored and parsed as a whole.
+class SrcmlTransformer : private XmlHandler
 {
+    // Kinds of elements which affect type of leaves.
+    enum class Tag : std::uint8_t
+    {
+        Other, Literal, Specifier, Comment, Operator, Name, Type, Function, Call
+    };
+
+    // Information about an element name.
+    struct TagInfo
+    {
+        SType stype;       // SType of nodes of this kind.
+        Tag tag;           // Kind of the element.
+        bool cppDirective; // Whether element is a preprocessor directive.
+    };
+
+    // Hashes contents of a string.
+    struct Hash
+    {
+        std::size_t operator()(boost::string_ref str) const;
+    };
+
+    // Element which is being processed.
+    struct Element
+    {
+        PNode *pnode;      // Node that corresponds to the element.
+        Tag tag;           // Kind of the element.
+        Type literalType;  // Type of literal for literal elements.
+        bool cppDirective; // Whether element is a preprocessor directive.
+        bool firstChild;   // Whether element is the first child of its parent.
+        int nChildren;     // Number of child nodes seen so far.
+    };
+
 public:
     // Remembers parameters to use them later.  `contents`, `map` and `keywords`
     // have to be lvalues.
@@ -50,13 +84,32 @@ public:
     void transform();
 
 private:
-    // Transforms single element into a node.
-    PNode * visit(tinyxml2::XMLNode *node, int level);
+    // Converts contents by streaming output of a started srcml process.
+    // Returns `false` on failure.
+    bool stream();
+    // Runs srcml on a temporary file and then on standard input if the first
+    // attempt doesn't produce anything.  Throws `std::runtime_error` on
+    // failure.
+    void invokeSrcml();
+    // Processes complete srcML.  Returns `false` if it has no root element.
+    // Throws `std::runtime_error` on malformed input.
+    bool parse(const std::string &xml);
+    // Prepares for processing of a new srcML document.
+    void reset();
+
+    // Implementation of XmlHandler.
+    void startElement(boost::string_ref name,
+                      const std::vector<XmlAttr> &attrs) override;
+    void endElement() override;
+    void text(boost::string_ref text) override;
+
+    // Transforms text which was seen last.  `atEnd` is set when it's followed
+    // by closing tag of its parent.
+    void flushText(bool atEnd);
     // Transforms text field.
-    void visitLeaf(tinyxml2::XMLNode *parent, PNode *pnode,
-                   tinyxml2::XMLNode *leaf);
-    // Determines type of a child of the specified element.
-    Type determineType(tinyxml2::XMLElement *elem, boost::string_ref value);
+    void visitLeaf(boost::string_ref text, bool onlyChild);
+    // Determines type of a child of the current element.
+    Type determineType(boost::string_ref value) const;
 
 private:
     const std::string &contents;                       // Contents to parse.
@@ -69,6 +122,16 @@ private:
     int line;                                          // Current line.
     int col;                                           // Current column.
     int inCppDirective;                                // Level of cpp nesting.
+
+    // Element name -> information about it.
+    std::unordered_map<boost::string_ref, TagInfo, Hash> tags;
+    SType separator;              // SType of separators.
+    PNode *root;                  // Root of the tree or `nullptr`.
+    std::vector<Element> stack;   // Elements which are being processed.
+    int ignored;                  // Nesting level of ignored elements.
+    std::string pendingText;      // Text whose siblings aren't known yet.
+    bool hasPendingText;          // Whether `pendingText` is set.
+    bool pendingFirst;            // Whether `pendingText` is the first child.
 };
 
 #endif // ZOGRASCOPE__SRCML__SRCMLTRANSFORMER_HPP__
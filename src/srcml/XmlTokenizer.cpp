@@ -0,0 +1,362 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "XmlTokenizer.hpp"
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+static bool isNameEnd(char c);
+static bool isSpace(char c);
+static bool decodeCharRef(boost::string_ref &str, std::string &out);
+
+XmlTokenizer::XmlTokenizer(XmlHandler &handler) : handler(handler), depth(0)
+{ }
+
+bool
+XmlTokenizer::feed(boost::string_ref piece)
+{
+    if (!error.empty()) {
+        return false;
+    }
+
+    buf.append(piece.begin(), piece.end());
+    buf.erase(0U, process(false));
+    return error.empty();
+}
+
+bool
+XmlTokenizer::finish()
+{
+    if (error.empty()) {
+        buf.erase(0U, process(true));
+    }
+    if (error.empty() && !buf.empty()) {
+        fail("Unterminated markup");
+    }
+    if (error.empty() && depth != 0) {
+        fail("Unclosed element");
+    }
+    return error.empty();
+}
+
+std::size_t
+XmlTokenizer::process(bool last)
+{
+    const boost::string_ref input = buf;
+
+    std::size_t pos = 0U;
+    while (pos < input.size() && error.empty()) {
+        const boost::string_ref rest = input.substr(pos);
+
+        if (rest.front() != '<') {
+            std::size_t end = rest.find('<');
+            if (end == boost::string_ref::npos) {
+                if (!last) {
+                    // Text might continue in the next piece.
+                    break;
+                }
+                end = rest.size();
+            }
+            processText(rest.substr(0U, end), false);
+            pos += end;
+            continue;
+        }
+
+        // Determine terminator of the markup.
+        boost::string_ref terminator = ">";
+        if (rest.starts_with("<?")) {
+            terminator = "?>";
+        } else if (rest.starts_with("<!--")) {
+            terminator = "-->";
+        } else if (rest.starts_with("<![CDATA[")) {
+            terminator = "]]>";
+        } else if (rest.size() < 9U && !last &&
+                   (boost::string_ref("<![CDATA[").starts_with(rest) ||
+                    boost::string_ref("<!--").starts_with(rest))) {
+            // Not enough data to determine kind of markup.
+            break;
+        }
+
+        std::size_t end;
+        if (terminator.size() == 1U) {
+            // Tags can contain '>' inside quoted attribute values.
+            char quote = '\0';
+            for (end = 1U; end < rest.size(); ++end) {
+                const char c = rest[end];
+                if (quote != '\0') {
+                    quote = (c == quote ? '\0' : quote);
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '>') {
+                    break;
+                }
+            }
+            if (end == rest.size()) {
+                end = boost::string_ref::npos;
+            }
+        } else {
+            end = rest.find(terminator);
+        }
+
+        if (end == boost::string_ref::npos) {
+            // Markup must be finished in one of the next pieces.
+            break;
+        }
+
+        const boost::string_ref markup = rest.substr(0U, end);
+        if (rest.starts_with("<![CDATA[")) {
+            processText(markup.substr(9U), true);
+        } else if (rest[1] != '?' && rest[1] != '!') {
+            static_cast<void>(processTag(markup.substr(1U)));
+        }
+        pos += end + terminator.size();
+    }
+
+    return pos;
+}
+
+bool
+XmlTokenizer::processTag(boost::string_ref tag)
+{
+    if (tag.starts_with('/')) {
+        if (depth == 0) {
+            fail("Unexpected closing tag");
+            return false;
+        }
+        --depth;
+        handler.endElement();
+        return true;
+    }
+
+    const bool empty = tag.ends_with('/');
+    if (empty) {
+        tag.remove_suffix(1U);
+    }
+
+    std::size_t nameLen = 0U;
+    while (nameLen < tag.size() && !isNameEnd(tag[nameLen])) {
+        ++nameLen;
+    }
+    if (nameLen == 0U) {
+        fail("Element without a name");
+        return false;
+    }
+    const boost::string_ref name = tag.substr(0U, nameLen);
+    tag.remove_prefix(nameLen);
+
+    // Values are decoded into a single string whose size is bounded by size
+    // of the tag, so it won't be reallocated while we're referring to it.
+    decoded.clear();
+    decoded.reserve(tag.size());
+    attrs.clear();
+
+    while (true) {
+        while (!tag.empty() && isSpace(tag.front())) {
+            tag.remove_prefix(1U);
+        }
+        if (tag.empty()) {
+            break;
+        }
+
+        const std::size_t eq = tag.find('=');
+        if (eq == boost::string_ref::npos) {
+            fail("Attribute without a value");
+            return false;
+        }
+        boost::string_ref attrName = tag.substr(0U, eq);
+        while (!attrName.empty() && isSpace(attrName.back())) {
+            attrName.remove_suffix(1U);
+        }
+        tag.remove_prefix(eq + 1U);
+        while (!tag.empty() && isSpace(tag.front())) {
+            tag.remove_prefix(1U);
+        }
+
+        if (tag.empty() || (tag.front() != '"' && tag.front() != '\'')) {
+            fail("Unquoted attribute value");
+            return false;
+        }
+        std::size_t close = tag.substr(1U).find(tag.front());
+        if (close == boost::string_ref::npos) {
+            fail("Unterminated attribute value");
+            return false;
+        }
+        ++close;
+
+        const std::size_t from = decoded.size();
+        decode(tag.substr(1U, close - 1U), true, decoded);
+        attrs.push_back({ attrName,
+                          boost::string_ref(decoded).substr(from) });
+        tag.remove_prefix(close + 1U);
+    }
+
+    ++depth;
+    handler.startElement(name, attrs);
+    if (empty) {
+        --depth;
+        handler.endElement();
+    }
+    return true;
+}
+
+void
+XmlTokenizer::processText(boost::string_ref text, bool cdata)
+{
+    if (!cdata && std::all_of(text.begin(), text.end(), &isSpace)) {
+        return;
+    }
+    if (depth == 0) {
+        // Text outside of elements is of no interest.
+        return;
+    }
+
+    decoded.clear();
+    // Only line endings are normalized in CDATA.
+    decode(text, !cdata, decoded);
+    handler.text(decoded);
+}
+
+void
+XmlTokenizer::decode(boost::string_ref str, bool expandEntities,
+                     std::string &out)
+{
+    while (!str.empty()) {
+        const char c = str.front();
+        if (c == '\r' || c == '\n') {
+            // Both "\r\n" and "\n\r" are turned into a single "\n".
+            const char other = (c == '\r' ? '\n' : '\r');
+            str.remove_prefix(str.size() > 1U && str[1] == other ? 2U : 1U);
+            out += '\n';
+            continue;
+        }
+
+        if (c == '&' && expandEntities) {
+            struct Entity { const char *name; char value; };
+            static const Entity entities[] = {
+                { "quot;", '"' }, { "amp;", '&' }, { "apos;", '\'' },
+                { "lt;", '<' }, { "gt;", '>' },
+            };
+
+            if (str.starts_with("&#") && decodeCharRef(str, out)) {
+                continue;
+            }
+
+            bool found = false;
+            for (const Entity &entity : entities) {
+                if (str.substr(1U).starts_with(entity.name)) {
+                    out += entity.value;
+                    str.remove_prefix(1U + std::char_traits<char>::length(
+                                                entity.name));
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                continue;
+            }
+        }
+
+        out += c;
+        str.remove_prefix(1U);
+    }
+}
+
+void
+XmlTokenizer::fail(const std::string &what)
+{
+    if (error.empty()) {
+        error = what;
+    }
+}
+
+// Checks whether character terminates name of an element.
+static bool
+isNameEnd(char c)
+{
+    return isSpace(c) || c == '/' || c == '>';
+}
+
+// Checks whether character is a whitespace in the same way tinyxml2 does.
+static bool
+isSpace(char c)
+{
+    const auto uc = static_cast<unsigned char>(c);
+    return uc < 128U && std::isspace(uc);
+}
+
+// Decodes numeric character reference at the beginning of the string into
+// UTF-8.  Returns `false` if there is no valid reference.
+static bool
+decodeCharRef(boost::string_ref &str, std::string &out)
+{
+    const std::size_t semicolon = str.find(';');
+    if (semicolon == boost::string_ref::npos) {
+        return false;
+    }
+
+    boost::string_ref digits = str.substr(2U, semicolon - 2U);
+    const bool hex = digits.starts_with('x');
+    if (hex) {
+        digits.remove_prefix(1U);
+    }
+    if (digits.empty() || digits.size() > 8U) {
+        return false;
+    }
+
+    std::uint32_t code = 0U;
+    for (char c : digits) {
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (hex && c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (hex && c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        code = code*(hex ? 16U : 10U) + digit;
+    }
+
+    if (code < 0x80U) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800U) {
+        out += static_cast<char>(0xc0U | (code >> 6));
+        out += static_cast<char>(0x80U | (code & 0x3fU));
+    } else if (code < 0x10000U) {
+        out += static_cast<char>(0xe0U | (code >> 12));
+        out += static_cast<char>(0x80U | ((code >> 6) & 0x3fU));
+        out += static_cast<char>(0x80U | (code & 0x3fU));
+    } else if (code < 0x200000U) {
+        out += static_cast<char>(0xf0U | (code >> 18));
+        out += static_cast<char>(0x80U | ((code >> 12) & 0x3fU));
+        out += static_cast<char>(0x80U | ((code >> 6) & 0x3fU));
+        out += static_cast<char>(0x80U | (code & 0x3fU));
+    } else {
+        return false;
+    }
+
+    str.remove_prefix(semicolon + 1U);
+    return true;
+}
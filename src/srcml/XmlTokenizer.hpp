@@ -0,0 +1,100 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__SRCML__XMLTOKENIZER_HPP__
+#define ZOGRASCOPE__SRCML__XMLTOKENIZER_HPP__
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+// Attribute of an element.
+struct XmlAttr
+{
+    boost::string_ref name;  // Name of the attribute.
+    boost::string_ref value; // Value with entities expanded.
+};
+
+// Receiver of events produced by `XmlTokenizer`.  Strings passed to methods
+// are valid only until the method returns.
+class XmlHandler
+{
+public:
+    // Virtual destructor for a base class.
+    virtual ~XmlHandler() = default;
+
+public:
+    // Called on opening tag of an element (including empty ones).
+    virtual void startElement(boost::string_ref name,
+                              const std::vector<XmlAttr> &attrs) = 0;
+    // Called on closing tag of an element (including empty ones).
+    virtual void endElement() = 0;
+    // Called on text that isn't made of whitespace only, which is how text
+    // nodes are treated by tinyxml2.  Entities are expanded and line endings
+    // are normalized.
+    virtual void text(boost::string_ref text) = 0;
+};
+
+// Streaming tokenizer of a subset of XML sufficient for parsing srcML.  Input
+// can be split into pieces at arbitrary positions, only incomplete markup or
+// text is kept in memory.
+class XmlTokenizer
+{
+public:
+    // Remembers handler to report events to.
+    explicit XmlTokenizer(XmlHandler &handler);
+
+public:
+    // Processes next piece of input.  Returns `false` on error.
+    bool feed(boost::string_ref piece);
+    // Finishes processing of the input.  Returns `false` if there was an
+    // error or input is incomplete.
+    bool finish();
+
+    // Retrieves description of the first error.
+    const std::string & getError() const
+    {
+        return error;
+    }
+
+private:
+    // Processes complete tokens in the buffer.  Returns position of the first
+    // unprocessed character.
+    std::size_t process(bool last);
+    // Processes a tag.  Returns `false` on error.
+    bool processTag(boost::string_ref tag);
+    // Reports text to the handler unless it consists of whitespace only.
+    void processText(boost::string_ref text, bool cdata);
+    // Normalizes line endings and optionally expands entities appending result
+    // to the string.
+    static void decode(boost::string_ref str, bool expandEntities,
+                       std::string &out);
+    // Records an error unless there is one already.
+    void fail(const std::string &what);
+
+private:
+    XmlHandler &handler;         // Receiver of events.
+    std::string buf;             // Unprocessed input.
+    std::string decoded;         // Storage for expanded strings.
+    std::vector<XmlAttr> attrs;  // Storage for attributes.
+    int depth;                   // Current nesting level of elements.
+    std::string error;           // Error message, empty if there is none.
+};
+
+#endif // ZOGRASCOPE__SRCML__XMLTOKENIZER_HPP__
@@ -307,7 +307,7 @@ postProcessIfStmt(PNode *node, TreeBuilder &tb, const std::string &contents)
 
         PNode *newNode = tb.addNode();
         newNode->stype = +SrcmlCxxSType::Elseif;
-        newNode->children = { elseKw, tailNode };
+        newNode->children.assign({ elseKw, tailNode });
         prev->children.push_back(newNode);
     }
 
@@ -336,8 +336,8 @@ postProcessBlock(PNode *node, TreeBuilder &tb, const std::string &contents)
         }
 
         // Splice children of block-content in its place.
-        node->children.erase(++node->children.cbegin());
-        node->children.insert(++node->children.cbegin(),
+        node->children.erase(node->children.cbegin() + 1);
+        node->children.insert(node->children.cbegin() + 1,
                               content->children.cbegin(),
                               content->children.cend());
     }
@@ -346,12 +346,12 @@ postProcessBlock(PNode *node, TreeBuilder &tb, const std::string &contents)
     if (node->children.size() > 2) {
         PNode *stmts = tb.addNode();
         stmts->stype = +SrcmlCxxSType::Statements;
-        stmts->children.assign(++node->children.cbegin(),
-                               --node->children.cend());
+        stmts->children.assign(node->children.cbegin() + 1,
+                               node->children.cend() - 1);
 
-        node->children.erase(++node->children.cbegin(),
-                             --node->children.cend());
-        node->children.insert(++node->children.cbegin(), stmts);
+        node->children.erase(node->children.cbegin() + 1,
+                             node->children.cend() - 1);
+        node->children.insert(node->children.cbegin() + 1, stmts);
         return;
     }
 
@@ -363,7 +363,8 @@ postProcessBlock(PNode *node, TreeBuilder &tb, const std::string &contents)
     // Children: statement (possibly in multiple pieces).
     PNode *stmts = tb.addNode();
     stmts->stype = +SrcmlCxxSType::Statements;
-    stmts->children = node->children;
+    stmts->children.assign(node->children.cbegin(),
+                           node->children.cend());
 
     node->children.assign({ stmts });
 }
@@ -557,7 +558,7 @@ postProcessConditional(PNode *node, TreeBuilder &/*tb*/,
                           cond->children.front());
 
     cond->children.erase(cond->children.begin());
-    cond->children.erase(--cond->children.end());
+    cond->children.erase(cond->children.end() - 1);
 }
 
 bool
@@ -20,13 +20,10 @@
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/optional.hpp>
 
-#include "pmr/monolithic.hpp"
-
 #include <iostream>
 #include <string>
 
 #include "utils/optional.hpp"
-#include "ColorScheme.hpp"
 #include "Grepper.hpp"
 #include "Matcher.hpp"
 #include "TermHighlighter.hpp"
@@ -134,9 +131,9 @@ Finder::search()
 bool
 Finder::process(const std::string &path)
 {
-    static ColorScheme cs;
+    // Trees of the previous file are gone by now, reuse memory they occupied.
+    mr.release();
 
-    cpp17::pmr::monolithic mr;
     if (optional_t<Tree> &&t = buildTreeFromFile(path, args, tr, &mr)) {
         auto timer = tr.measure("looking: " + path);
 
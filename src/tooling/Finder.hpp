@@ -22,6 +22,9 @@
 #include <deque>
 #include <string>
 
+#include "pmr/monolithic.hpp"
+
+#include "ColorScheme.hpp"
 #include "Grepper.hpp"
 #include "Matcher.hpp"
 
@@ -54,6 +57,8 @@ private:
     std::vector<std::string> paths; // List of paths to process.
     std::deque<Matcher> matchers;   // Storage of matchers.
     Grepper grepper;                // Finder of consecutive tokens.
+    ColorScheme cs;                 // Color scheme for printing matches.
+    cpp17::pmr::monolithic mr;      // Arena reused for trees of all files.
 };
 
 #endif // ZOGRASCOPE__TOOLING__FINDER_HPP__
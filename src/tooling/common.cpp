@@ -16,6 +16,9 @@
 
 #include "common.hpp"
 
+#include <cstddef>
+
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -136,15 +139,28 @@ buildTreeFromFile(const std::string &path, const CommonArgs &args,
 optional_t<Tree>
 buildTreeFromFile(const std::string &path, const std::string &contents,
                   const CommonArgs &args, TimeReport &tr,
-                  cpp17::pmr::memory_resource *mr)
+                  cpp17::pmr::memory_resource *mr, ParseCache *cache)
 {
     auto timer = tr.measure("parsing: " + path);
 
     std::unique_ptr<Language> lang = Language::create(path, args.lang);
 
-    cpp17::pmr::monolithic localMR;
-
-    TreeBuilder tb = lang->parse(contents, path, args.debug, localMR);
+    // Parse and syntax trees take roughly this many bytes per byte of input,
+    // this avoids lots of small allocations for large files.  The hint is
+    // capped to not reserve gigabytes of memory for huge inputs up front.
+    constexpr std::size_t arenaBytesPerInputByte = 32U;
+    constexpr std::size_t maxArenaHint = 32U*1024U*1024U;
+    constexpr std::size_t hugePageSize = 2U*1024U*1024U;
+    const std::size_t arenaHint =
+        std::min(contents.size(), maxArenaHint/arenaBytesPerInputByte)
+      * arenaBytesPerInputByte;
+    cpp17::pmr::monolithic localMR(arenaHint);
+    // Huge pages are worth it only for blocks that span at least one of them.
+    localMR.useHugePages(arenaHint >= hugePageSize);
+
+    TreeBuilder tb = (cache == nullptr)
+                   ? lang->parse(contents, path, args.debug, localMR)
+                   : lang->reparse(contents, path, args.debug, *cache, localMR);
     if (tb.hasFailed()) {
         return {};
     }
@@ -153,10 +169,13 @@ buildTreeFromFile(const std::string &path, const std::string &contents,
 
     if (args.fine) {
         t = Tree(std::move(lang), contents, tb.getRoot(), mr);
-    } else {
+    } else if (args.dumpSTree || args.sdebug) {
         STree stree(std::move(tb), contents, args.dumpSTree, args.sdebug,
                     *lang, localMR);
         t = Tree(std::move(lang), contents, stree.getRoot(), mr);
+    } else {
+        // Building STree isn't necessary and takes extra memory.
+        t = Tree(std::move(lang), contents, tb.getRoot(), mr, true);
     }
 
     return optional_t<Tree>(std::move(t));
@@ -27,6 +27,7 @@
 #include "utils/time.hpp"
 #include "integration.hpp"
 
+class ParseCache;
 class Tree;
 
 namespace cpp17 {
@@ -99,12 +100,14 @@ optional_t<Tree> buildTreeFromFile(const std::string &path,
                                    TimeReport &tr,
                                    cpp17::pmr::memory_resource *mr);
 
-// Parses a file to build its tree.
+// Parses a file to build its tree.  Non-null cache allows reusing results of
+// parsing previous versions of the file (the tree is still built in full).
 optional_t<Tree> buildTreeFromFile(const std::string &path,
                                    const std::string &contents,
                                    const CommonArgs &args,
                                    TimeReport &tr,
-                                   cpp17::pmr::memory_resource *mr);
+                                   cpp17::pmr::memory_resource *mr,
+                                   ParseCache *cache = nullptr);
 
 void dumpTree(const CommonArgs &args, Tree &tree);
 
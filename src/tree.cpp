@@ -50,12 +50,11 @@ constexpr int subtreeOverlapSize = 3;
 static void putNodeChild(Node &parent, Node *child, const Language *lang);
 static void preStringifyPTree(const std::string &contents,
                               PNode *node, const Language *lang,
-                              cpp17::pmr::vector<char> &stringified);
+                              cpp17::pmr::vector<char> &stringified,
+                              std::vector<boost::string_ref> &labels);
 static boost::string_ref
-stringifyPNode(const cpp17::pmr::vector<char> &stringified, const PNode *node);
-static void preStringifyPNode(const std::string &contents, PNode *node,
-                              const Language *lang,
-                              cpp17::pmr::vector<char> &stringified);
+preStringifyPNode(const std::string &contents, const PNode *node,
+                  const Language *lang, cpp17::pmr::vector<char> &stringified);
 static std::string stringifyPNodeSpelling(const std::string &contents,
                                           const PNode *node);
 static int maxStringifiedSize(boost::string_ref contents);
@@ -72,96 +71,174 @@ static void dumpTree(std::ostream &os, const Node *node, const Language *lang,
 static void dumpNode(std::ostream &os, const Node *node, const Language *lang);
 
 Tree::Tree(std::unique_ptr<Language> lang, const std::string &contents,
-           const PNode *node, allocator_type al)
-    : lang(std::move(lang)), nodes(al), stringified(al), internPool(al)
+           const SNode *node, allocator_type al)
+    : lang(std::move(lang)), nodes(al), stringified(al), interner(al)
 {
     stringified.reserve(maxStringifiedSize(contents));
     const char *buf = stringified.data();
 
-    preStringifyPTree(contents, const_cast<PNode *>(node), this->lang.get(),
-                      stringified);
-    root = materializePNode(contents, node);
+    // Structure of SNode-tree is fully determined by the PNode-tree, so only
+    // the root is needed.
+    preStringifyPTree(contents, node->value, this->lang.get(), stringified,
+                      labels);
+    root = materializeSNode(contents, node->value, node->children.empty(),
+                            nullptr);
 
     assert(stringified.data() == buf && "Stringified buffer got relocated!");
     (void)buf;
+
+    labels.clear();
+    labels.shrink_to_fit();
 }
 
 Tree::Tree(std::unique_ptr<Language> lang, const std::string &contents,
-           const SNode *node, allocator_type al)
-    : lang(std::move(lang)), nodes(al), stringified(al), internPool(al)
+           const PNode *node, allocator_type al, bool coarse)
+    : lang(std::move(lang)), nodes(al), stringified(al), interner(al)
 {
     stringified.reserve(maxStringifiedSize(contents));
     const char *buf = stringified.data();
 
-    preStringifyPTree(contents, node->value, this->lang.get(), stringified);
-    root = materializeSNode(contents, node, nullptr);
+    preStringifyPTree(contents, const_cast<PNode *>(node), this->lang.get(),
+                      stringified, labels);
+    if (!coarse) {
+        root = materializePNode(contents, node);
+    } else if (const PNode *snode = findSNode(node)) {
+        root = materializeSNode(contents, snode, false, nullptr);
+    } else {
+        root = materializeSNode(contents, node, true, nullptr);
+    }
 
     assert(stringified.data() == buf && "Stringified buffer got relocated!");
     (void)buf;
+
+    labels.clear();
+    labels.shrink_to_fit();
 }
 
 Node *
-Tree::materializeSNode(const std::string &contents, const SNode *node,
-                       const SNode *parent)
+Tree::materializeSNode(const std::string &contents, const PNode *node,
+                       bool leaf, const PNode *parent)
 {
-    Node &n = *nodes.make();
-    n.stype = node->value->stype;
-    n.satellite = lang->isSatellite(n.stype);
-
-    if (node->children.empty()) {
-        const PNode *leftmostLeaf = node->value->leftmostChild();
-
-        n.label = stringifyPNode(stringified, node->value);
-        n.line = leftmostLeaf->line;
-        n.col = leftmostLeaf->col;
-        n.next = materializePNode(contents, node->value);
-        n.next->last = true;
-        n.type = n.next->type;
-        n.leaf = (n.line != 0 && n.col != 0);
+    // SNode whose children are being materialized.
+    struct Frame
+    {
+        Node *n;             // Node being built.
+        const PNode *node;   // PNode that defines the SNode.
+        const PNode *parent; // PNode of parent SNode or nullptr.
+        std::size_t first;   // Index of the first child's entry in `found`.
+        std::size_t next;    // Index of the next child to process.
+    };
+
+    // Nearest SNodes of children of nodes on the stack.
+    std::vector<PNode *> found;
+    std::vector<Frame> stack;
+
+    // Makes a node out of SNode.  Returns it if it's a leaf, otherwise
+    // schedules processing of its children and returns nullptr.
+    auto enter = [&](const PNode *node, bool leaf,
+                     const PNode *parent) -> Node * {
+        Node &n = *nodes.make();
+        n.stype = node->stype;
+        n.satellite = lang->isSatellite(n.stype);
+
+        // If none of the children is SNode, then current node is a leaf SNode.
+        const std::size_t first = found.size();
+        if (leaf || !findChildSNodes(node, found)) {
+            found.resize(first);
+
+            const PNode *leftmostLeaf =
+                const_cast<PNode *>(node)->leftmostChild();
+
+            n.label = labels[node->id];
+            n.line = leftmostLeaf->line;
+            n.col = leftmostLeaf->col;
+            n.next = materializePNode(contents, node);
+            n.next->last = true;
+            n.type = n.next->type;
+            n.leaf = (n.line != 0 && n.col != 0);
+            return &n;
+        }
+
+        n.valueChild = -1;
+        n.children.reserve(node->children.size());
+        stack.push_back({ &n, node, parent, first, 0U });
+        return nullptr;
+    };
+
+    // Finishes node after all of its children were added.
+    auto leave = [&](const Frame &frame) -> Node * {
+        Node &n = *frame.n;
+
+        // The check below can be true if putNodeChild() decided to not add
+        // any children.
+        if (!n.children.empty()) {
+            n.line = n.children.front()->line;
+            n.col = n.children.front()->col;
+        }
+
+        // Move certain nodes onto the next layer.
+        SType parentSType = (frame.parent == nullptr ? SType{}
+                                                     : frame.parent->stype);
+        if (lang->isLayerBreak(parentSType, n.stype)) {
+            Node &nextLevel = *nodes.make();
+            nextLevel.next = &n;
+            nextLevel.stype = n.stype;
+            nextLevel.line = n.line;
+            nextLevel.col = n.col;
+
+            int len = labels[frame.node->id].size();
+            nextLevel.label = n.label.empty()
+                            ? intern(printSubTree(n, false, len))
+                            : n.label;
+            return &nextLevel;
+        }
+
         return &n;
-    }
+    };
 
-    n.children.reserve(node->children.size());
-    for (SNode *child : node->children) {
-        Node *newChild = materializeSNode(contents, child, node);
+    // Adds the most recently processed child to the node on top of the stack.
+    auto addChild = [&](const PNode *child, Node *newChild) {
+        Frame &frame = stack.back();
+        Node &n = *frame.n;
         putNodeChild(n, newChild, lang.get());
-    }
 
-    // The check below can be true if putNodeChild() decided to not add any
-    // children.
-    if (!n.children.empty()) {
-        n.line = n.children.front()->line;
-        n.col = n.children.front()->col;
-    }
+        if (n.valueChild == -1 && lang->isValueNode(child->stype)) {
+            n.label = labels[child->id];
+            n.valueChild = frame.next - 1U;
+        }
+    };
 
-    auto valueChild = std::find_if(node->children.begin(), node->children.end(),
-                                   [this](const SNode *node) {
-                                       const SType stype = node->value->stype;
-                                       return lang->isValueNode(stype);
-                                   });
-    if (valueChild != node->children.end()) {
-        n.label = stringifyPNode(stringified, (*valueChild)->value);
-        n.valueChild = valueChild - node->children.begin();
-    } else {
-        n.valueChild = -1;
-    }
+    Node *root = enter(node, leaf, parent);
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
 
-    // Move certain nodes onto the next layer.
-    SType parentSType = (parent == nullptr ? SType{} : parent->value->stype);
-    if (lang->isLayerBreak(parentSType, n.stype)) {
-        Node &nextLevel = *nodes.make();
-        nextLevel.next = &n;
-        nextLevel.stype = n.stype;
-        nextLevel.line = n.line;
-        nextLevel.col = n.col;
+        if (frame.next == frame.node->children.size()) {
+            const Frame done = frame;
+            found.resize(done.first);
+            stack.pop_back();
 
-        int len = node->value->value.postponedTo;
-        nextLevel.label = n.label.empty() ? intern(printSubTree(n, false, len))
-                                          : n.label;
-        return &nextLevel;
-    }
+            Node *newNode = leave(done);
+            if (stack.empty()) {
+                root = newNode;
+            } else {
+                addChild(done.node, newNode);
+            }
+            continue;
+        }
 
-    return &n;
+        const std::size_t i = frame.next++;
+        const PNode *child = frame.node->children[i];
+        const PNode *schild = found[frame.first + i];
+        if (schild != nullptr) {
+            child = schild;
+        }
+
+        // This invalidates `frame`.
+        if (Node *newChild = enter(child, schild == nullptr, frame.node)) {
+            addChild(child, newChild);
+        }
+    }
+    return root;
 }
 
 // Adds child or its children (when child is spliced) to the parent node.
@@ -192,22 +269,27 @@ putNodeChild(Node &parent, Node *child, const Language *lang)
     }
 }
 
-// Turns tree into a string.  Stores boundaries of nodes label in
-// value.postponedFrom (start index) and value.postponedTo (length).
+// Turns tree into a string.  Assigns identifiers to nodes and stores their
+// labels in `labels` at corresponding indexes.
 static void
 preStringifyPTree(const std::string &contents, PNode *node,
-                  const Language *lang, cpp17::pmr::vector<char> &stringified)
+                  const Language *lang, cpp17::pmr::vector<char> &stringified,
+                  std::vector<boost::string_ref> &labels)
 {
     struct {
         const std::string &contents;
         const Language *lang;
         cpp17::pmr::vector<char> &out;
+        std::vector<boost::string_ref> &labels;
         void run(PNode *node)
         {
-            node->value.postponedFrom = out.size();
+            const std::size_t from = out.size();
+            node->id = labels.size();
+            labels.emplace_back();
 
             if (node->line != 0 && node->col != 0) {
-                preStringifyPNode(contents, node, lang, out);
+                labels[node->id] = preStringifyPNode(contents, node, lang,
+                                                     out);
             }
 
             for (PNode *child : node->children) {
@@ -215,11 +297,11 @@ preStringifyPTree(const std::string &contents, PNode *node,
             }
 
             if (node->line == 0 || node->col == 0) {
-                node->value.postponedTo = out.size()
-                                        - node->value.postponedFrom;
+                labels[node->id] = boost::string_ref(out.data() + from,
+                                                     out.size() - from);
             }
         }
-    } visitor { contents, lang, stringified };
+    } visitor { contents, lang, stringified, labels };
 
     visitor.run(node);
 }
@@ -234,8 +316,10 @@ Tree::materializePNode(const std::string &contents, const PNode *node)
     }
 
     Node &n = *nodes.make();
-    n.label = stringifyPNode(stringified, node);
-    if (lang->shouldDropLeadingWS(node->stype)) {
+    n.label = labels[node->id];
+    // Label differs from spelling only in whitespace that follows newlines.
+    if (lang->shouldDropLeadingWS(node->stype) &&
+        n.label.find('\n') != boost::string_ref::npos) {
         n.spelling = intern(stringifyPNodeSpelling(contents, node));
     } else {
         n.spelling = n.label;
@@ -254,21 +338,13 @@ Tree::materializePNode(const std::string &contents, const PNode *node)
     return &n;
 }
 
-// Turns PNode into a string.
+// Turns node into a string by appending its label to `stringified`.  Returns
+// the label.
 static boost::string_ref
-stringifyPNode(const cpp17::pmr::vector<char> &stringified, const PNode *node)
-{
-    return boost::string_ref(stringified.data() + node->value.postponedFrom,
-                             node->value.postponedTo);
-}
-
-// Turns node into a string.  Stores boundaries of this node's label in
-// value.postponedFrom (start index) and value.postponedTo (length).
-static void
-preStringifyPNode(const std::string &contents, PNode *node,
+preStringifyPNode(const std::string &contents, const PNode *node,
                   const Language *lang, cpp17::pmr::vector<char> &stringified)
 {
-    node->value.postponedFrom = stringified.size();
+    const std::size_t from = stringified.size();
 
     bool leadingWhitespace = false;
     int col = node->col;
@@ -304,7 +380,8 @@ preStringifyPNode(const std::string &contents, PNode *node,
         }
     }
 
-    node->value.postponedTo = stringified.size() - node->value.postponedFrom;
+    return boost::string_ref(stringified.data() + from,
+                             stringified.size() - from);
 }
 
 // Computes node label only expanding tabs in it.
@@ -787,8 +864,7 @@ Tree::propagateStates()
 }
 
 boost::string_ref
-Tree::intern(std::string &&str)
+Tree::intern(boost::string_ref str)
 {
-    internPool.push_back(std::move(str));
-    return internPool.back();
+    return interner.intern(str);
 }
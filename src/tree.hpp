@@ -25,9 +25,9 @@
 #include <string>
 #include <vector>
 
-#include "pmr/pmr_deque.hpp"
 #include "pmr/pmr_vector.hpp"
 
+#include "utils/Interner.hpp"
 #include "utils/Pool.hpp"
 #include "Language.hpp"
 #include "types.hpp"
@@ -121,12 +121,14 @@ class Tree
     using allocator_type = cpp17::pmr::polymorphic_allocator<cpp17::byte>;
 
 public:
-    Tree(allocator_type al = {}) : nodes(al), stringified(al), internPool(al)
+    Tree(allocator_type al = {}) : nodes(al), stringified(al), interner(al)
     { }
     Tree(const Tree &rhs) = delete;
     Tree(Tree &&rhs) = default;
+    // Builds either fine or coarse tree right from the PNode-tree.  Coarse tree
+    // is the same as the one made out of STree, but without constructing one.
     Tree(std::unique_ptr<Language> lang, const std::string &contents,
-         const PNode *node, allocator_type al = {});
+         const PNode *node, allocator_type al = {}, bool coarse = false);
     Tree(std::unique_ptr<Language> lang, const std::string &contents,
          const SNode *node, allocator_type al = {});
 
@@ -176,14 +178,15 @@ public:
     void propagateStates();
 
 private:
-    // Turns SNode-subtree into a corresponding Node-subtree.
-    Node * materializeSNode(const std::string &contents,
-                            const SNode *node, const SNode *parent);
+    // Turns SNode-subtree into a corresponding Node-subtree.  The SNode is
+    // represented by its PNode, `leaf` forces it to be a leaf SNode.
+    Node * materializeSNode(const std::string &contents, const PNode *node,
+                            bool leaf, const PNode *parent);
     // Turns PNode-subtree into a corresponding Node-subtree.
     Node * materializePNode(const std::string &contents, const PNode *node);
 
     // Interns a string.
-    boost::string_ref intern(std::string &&str);
+    boost::string_ref intern(boost::string_ref str);
 
 private:
     std::unique_ptr<Language> lang;
@@ -192,8 +195,11 @@ private:
     Node *root = nullptr;
     // Storage of most labels and spelling.
     cpp17::pmr::vector<char> stringified;
+    // Labels of PNodes indexed by PNode::id, exists only while the tree is
+    // being built.
+    std::vector<boost::string_ref> labels;
     // Storage for interned strings.
-    cpp17::pmr::deque<std::string> internPool;
+    Interner interner;
 };
 
 std::vector<Node *> postOrder(Node &root);
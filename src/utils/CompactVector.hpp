@@ -0,0 +1,304 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__UTILS__COMPACTVECTOR_HPP__
+#define ZOGRASCOPE__UTILS__COMPACTVECTOR_HPP__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+#include "pmr/polymorphic_allocator.hpp"
+
+// Vector of trivially copyable elements that occupies 16 bytes.  Size and
+// capacity are 32-bit and memory resource is stored in front of elements, so
+// that empty vectors (the most common ones) don't need storage for it.  Only
+// subset of std::vector interface that is actually used is provided.
+template <typename T>
+class CompactVector
+{
+    static_assert(std::is_trivial<T>::value,
+                  "Elements must be trivial to be moved around as bytes.");
+
+    // Storage is prepended with a header that points to the resource.
+    struct Header
+    {
+        cpp17::pmr::memory_resource *mr;
+    };
+
+public:
+    using allocator_type = cpp17::pmr::polymorphic_allocator<cpp17::byte>;
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+public:
+    explicit CompactVector(allocator_type al = {}) : mr(al.resource())
+    {
+    }
+    CompactVector(const CompactVector &rhs) = delete;
+    CompactVector(CompactVector &&rhs) : count(rhs.count), cap(rhs.cap)
+    {
+        steal(rhs);
+    }
+    CompactVector(CompactVector &&rhs, allocator_type al)
+        : mr(al.resource())
+    {
+        if (rhs.resource()->is_equal(*al.resource())) {
+            count = rhs.count;
+            cap = rhs.cap;
+            steal(rhs);
+        } else {
+            assign(rhs.cbegin(), rhs.cend());
+        }
+    }
+
+    CompactVector & operator=(const CompactVector &rhs) = delete;
+    CompactVector & operator=(CompactVector &&rhs) = delete;
+
+    ~CompactVector()
+    {
+        release();
+    }
+
+public:
+    iterator begin() { return data(); }
+    iterator end() { return data() + count; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + count; }
+    const_iterator cbegin() const { return data(); }
+    const_iterator cend() const { return data() + count; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const
+    { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const
+    { return const_reverse_iterator(begin()); }
+
+    size_type size() const { return count; }
+    size_type capacity() const { return cap; }
+    bool empty() const { return count == 0U; }
+
+    T & operator[](size_type i) { return data()[i]; }
+    const T & operator[](size_type i) const { return data()[i]; }
+    T & front() { return data()[0]; }
+    const T & front() const { return data()[0]; }
+    T & back() { return data()[count - 1U]; }
+    const T & back() const { return data()[count - 1U]; }
+
+    allocator_type get_allocator() const
+    {
+        return allocator_type(resource());
+    }
+
+    void reserve(size_type n)
+    {
+        if (n > cap) {
+            reallocate(n);
+        }
+    }
+
+    void clear()
+    {
+        count = 0U;
+    }
+
+    void push_back(const T &value)
+    {
+        insert(cend(), value);
+    }
+
+    void pop_back()
+    {
+        --count;
+    }
+
+    iterator insert(const_iterator pos, const T &value)
+    {
+        const T copy = value;
+        const iterator at = makeGap(pos, 1U);
+        *at = copy;
+        return at;
+    }
+
+    template <typename I>
+    iterator insert(const_iterator pos, I first, I last)
+    {
+        const size_type n = std::distance(first, last);
+        // Range must not come from this vector.
+        assert((n == 0U || cap == 0U || &*first < data() ||
+                &*first >= data() + cap) && "Inserting range from self!");
+        const iterator at = makeGap(pos, n);
+        std::copy(first, last, at);
+        return at;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const iterator from = begin() + (first - cbegin());
+        const size_type n = last - first;
+        if (n == 0U) {
+            return from;
+        }
+
+        std::memmove(static_cast<void *>(from), from + n,
+                     (end() - (from + n))*sizeof(T));
+        count -= n;
+        return from;
+    }
+
+    template <typename I>
+    void assign(I first, I last)
+    {
+        clear();
+        reserve(std::distance(first, last));
+        insert(cend(), first, last);
+    }
+
+    void assign(std::initializer_list<T> ini)
+    {
+        assign(ini.begin(), ini.end());
+    }
+
+    void swap(CompactVector &rhs)
+    {
+        std::swap(mr, rhs.mr);
+        std::swap(count, rhs.count);
+        std::swap(cap, rhs.cap);
+    }
+
+private:
+    // Retrieves pointer to the first element.
+    T * data() const
+    {
+        return (cap == 0U ? nullptr : elems);
+    }
+
+    // Retrieves memory resource used by this vector.
+    cpp17::pmr::memory_resource * resource() const
+    {
+        return (cap == 0U ? mr : header()->mr);
+    }
+
+    // Retrieves header that precedes elements.
+    Header * header() const
+    {
+        return reinterpret_cast<Header *>(reinterpret_cast<char *>(elems)
+                                        - offset());
+    }
+
+    // Makes space for n elements at specified position growing storage if
+    // needed.  Returns iterator to the first element of the gap.
+    iterator makeGap(const_iterator pos, size_type n)
+    {
+        const size_type at = pos - cbegin();
+        if (n == 0U) {
+            return begin() + at;
+        }
+
+        if (count + n > cap) {
+            reallocate(std::max<size_type>(count + n, 2U*cap));
+        }
+
+        const iterator gap = begin() + at;
+        std::memmove(static_cast<void *>(gap + n), gap,
+                     (count - at)*sizeof(T));
+        count += n;
+        return gap;
+    }
+
+    // Moves elements to a new storage of the specified capacity.
+    void reallocate(size_type newCap)
+    {
+        cpp17::pmr::memory_resource *const r = resource();
+        void *const mem = r->allocate(offset() + newCap*sizeof(T),
+                                      alignof(Header));
+        Header *const h = static_cast<Header *>(mem);
+        h->mr = r;
+
+        T *const newElems = reinterpret_cast<T *>(static_cast<char *>(mem)
+                                                + offset());
+        if (count != 0U) {
+            std::memcpy(static_cast<void *>(newElems), elems,
+                        count*sizeof(T));
+        }
+
+        const std::uint32_t size = count;
+        release();
+        elems = newElems;
+        count = size;
+        cap = newCap;
+    }
+
+    // Frees storage (if any) leaving vector empty.
+    void release()
+    {
+        if (cap != 0U) {
+            cpp17::pmr::memory_resource *const r = header()->mr;
+            r->deallocate(header(), offset() + cap*sizeof(T),
+                          alignof(Header));
+            mr = r;
+            cap = 0U;
+            count = 0U;
+        }
+    }
+
+    // Takes storage from another vector and leaves it empty.
+    void steal(CompactVector &rhs)
+    {
+        if (rhs.cap == 0U) {
+            mr = rhs.mr;
+        } else {
+            elems = rhs.elems;
+            rhs.mr = header()->mr;
+        }
+        rhs.count = 0U;
+        rhs.cap = 0U;
+    }
+
+    // Offset of elements from the beginning of storage.
+    static constexpr std::size_t offset()
+    {
+        return (sizeof(Header) + alignof(T) - 1U)/alignof(T)*alignof(T);
+    }
+
+private:
+    union
+    {
+        // Resource when there is no storage (capacity is zero).
+        cpp17::pmr::memory_resource *mr;
+        // Elements when capacity isn't zero.
+        T *elems;
+    };
+    std::uint32_t count = 0U;
+    std::uint32_t cap = 0U;
+};
+
+#endif // ZOGRASCOPE__UTILS__COMPACTVECTOR_HPP__
@@ -0,0 +1,177 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__UTILS__INTERNER_HPP__
+#define ZOGRASCOPE__UTILS__INTERNER_HPP__
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+
+#include "pmr/polymorphic_allocator.hpp"
+#include "pmr/pmr_vector.hpp"
+
+// Storage of unique strings.  Characters of strings are kept in chunks of
+// memory obtained from the allocator, so is the index used for deduplication.
+class Interner
+{
+    using allocator_type = cpp17::pmr::polymorphic_allocator<cpp17::byte>;
+
+    // Size of a regular chunk of characters.
+    static constexpr std::size_t chunkSize = 4*1024;
+
+    // Hashes contents of a string.
+    struct Hash
+    {
+        std::size_t operator()(boost::string_ref str) const
+        {
+            return boost::hash_range(str.begin(), str.end());
+        }
+    };
+
+    using index_type = std::unordered_set<
+        boost::string_ref, Hash, std::equal_to<boost::string_ref>,
+        cpp17::pmr::polymorphic_allocator<boost::string_ref>
+    >;
+
+    // Memory obtained from the allocator.
+    struct Chunk
+    {
+        char *data;
+        std::size_t size;
+    };
+
+public:
+    // Allocator must be specified, this class should not be used with a default
+    // allocator by mistake.
+    explicit Interner(allocator_type al)
+        : alloc(al), chunks(al), index(0U, Hash(), {}, al)
+    {
+    }
+
+    Interner(const Interner &rhs) = delete;
+    Interner(Interner &&rhs)
+        : alloc(rhs.alloc), chunks(std::move(rhs.chunks)),
+          index(std::move(rhs.index)), next(rhs.next), end(rhs.end)
+    {
+        rhs.forget();
+    }
+
+    Interner & operator=(const Interner &rhs) = delete;
+    Interner & operator=(Interner &&rhs)
+    {
+        if (this != &rhs) {
+            release();
+            alloc = rhs.alloc;
+            chunks = std::move(rhs.chunks);
+            index = std::move(rhs.index);
+            next = rhs.next;
+            end = rhs.end;
+            rhs.forget();
+        }
+        return *this;
+    }
+
+    ~Interner()
+    {
+        release();
+    }
+
+public:
+    // Retrieves stored copy of the string, adding one if necessary.  The result
+    // is valid until this object is destroyed.
+    boost::string_ref intern(boost::string_ref str)
+    {
+        auto it = index.find(str);
+        if (it != index.end()) {
+            return *it;
+        }
+
+        boost::string_ref copy(store(str), str.size());
+        index.insert(copy);
+        return copy;
+    }
+
+private:
+    // Copies characters of the string into a chunk.
+    char * store(boost::string_ref str)
+    {
+        const std::size_t size = str.size();
+
+        char *data;
+        if (size > chunkSize/4U) {
+            // Large strings get a chunk of their own to not waste space.
+            data = allocate(size);
+        } else {
+            if (static_cast<std::size_t>(end - next) < size) {
+                next = allocate(chunkSize);
+                end = next + chunkSize;
+            }
+            data = next;
+            next += size;
+        }
+
+        std::copy(str.begin(), str.end(), data);
+        return data;
+    }
+
+    // Obtains a new chunk of memory.
+    char * allocate(std::size_t size)
+    {
+        // Allocating at least one byte to never end up with null pointer.
+        size = std::max<std::size_t>(size, 1U);
+        void *data = alloc.resource()->allocate(size, 1U);
+        chunks.push_back({ static_cast<char *>(data), size });
+        return chunks.back().data;
+    }
+
+    // Gives all chunks back to the allocator.
+    void release()
+    {
+        for (const Chunk &chunk : chunks) {
+            alloc.resource()->deallocate(chunk.data, chunk.size, 1U);
+        }
+        forget();
+    }
+
+    // Drops all references to chunks without freeing them.
+    void forget()
+    {
+        index.clear();
+        chunks.clear();
+        next = nullptr;
+        end = nullptr;
+    }
+
+private:
+    // Allocator used for chunks.
+    allocator_type alloc;
+    // All chunks owned by this object.
+    cpp17::pmr::vector<Chunk> chunks;
+    // Index of strings stored in chunks.
+    index_type index;
+    // Free space of the current regular chunk.
+    char *next = nullptr;
+    char *end = nullptr;
+};
+
+#endif // ZOGRASCOPE__UTILS__INTERNER_HPP__
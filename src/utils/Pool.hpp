@@ -17,6 +17,8 @@
 #ifndef ZOGRASCOPE__UTILS__POOL_HPP__
 #define ZOGRASCOPE__UTILS__POOL_HPP__
 
+#include <cstddef>
+
 #include <utility>
 
 #include "pmr/polymorphic_allocator.hpp"
@@ -24,11 +26,17 @@
 // A fabric of objects of specified type that does NOT destruct them.  Must be
 // used only with types which don't do anything useful in destructors due to
 // allocator cleaning everything up for them.
+//
+// Objects are carved out of slabs (arrays of objects) by bumping a pointer, so
+// the allocator is consulted once per slab rather than once per object.
 template <typename T>
 class Pool
 {
     using allocator_type = cpp17::pmr::polymorphic_allocator<cpp17::byte>;
 
+    // Approximate size of a single slab in bytes.
+    static constexpr std::size_t slabBytes = 16*1024;
+
 public:
     // Allocator must be specified, this class should not be used with a default
     // allocator by mistake.
@@ -36,24 +44,69 @@ public:
     {
     }
 
+    Pool(const Pool &rhs) = delete;
+    Pool(Pool &&rhs) : alloc(rhs.alloc), next(rhs.next), end(rhs.end)
+    {
+        rhs.next = nullptr;
+        rhs.end = nullptr;
+    }
+
+    Pool & operator=(const Pool &rhs) = delete;
+    Pool & operator=(Pool &&rhs)
+    {
+        if (this != &rhs) {
+            alloc = rhs.alloc;
+            next = rhs.next;
+            end = rhs.end;
+            rhs.next = nullptr;
+            rhs.end = nullptr;
+        }
+        return *this;
+    }
+
+public:
     // Forwards everything to the constructor of the object.
     template <typename... Args>
     T * make(Args &&...args)
     {
-        auto data = static_cast<T *>(alloc.resource()->allocate(sizeof(T),
-                                                                alignof(T)));
-        try {
-            alloc.construct(data, std::forward<Args>(args)...);
-        } catch (...) {
-            alloc.resource()->deallocate(data, sizeof(T), alignof(T));
-            throw;
+        if (next == end) {
+            refill();
         }
 
+        auto data = reinterpret_cast<T *>(next);
+        alloc.construct(data, std::forward<Args>(args)...);
+        // Slot is consumed only after successful construction.
+        next += sizeof(T);
         return data;
     }
 
 private:
-    allocator_type alloc; // Allocator used for objects.
+    // Number of objects that fit in a single slab.
+    static constexpr std::size_t slabCapacity()
+    {
+        return (sizeof(T) >= slabBytes ? 1U : slabBytes/sizeof(T));
+    }
+
+    // Switches to a new slab.  Slabs are never given back by the pool, because
+    // objects can outlive it (e.g., when trees are stitched together), they
+    // are freed by the allocator instead.
+    void refill()
+    {
+        const std::size_t size = slabCapacity()*sizeof(T);
+        next = static_cast<cpp17::byte *>(alloc.resource()->allocate(size,
+                                                                  alignof(T)));
+        end = next + size;
+    }
+
+private:
+    // Allocator used for slabs.
+    allocator_type alloc;
+    // Next free slot and end of current slab.
+    cpp17::byte *next = nullptr;
+    cpp17::byte *end = nullptr;
 };
 
+template <typename T>
+constexpr std::size_t Pool<T>::slabBytes;
+
 #endif // ZOGRASCOPE__UTILS__POOL_HPP__
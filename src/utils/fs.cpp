@@ -19,12 +19,35 @@
 #include <boost/filesystem/operations.hpp>
 
 #include <fstream>
+#include <ios>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 #include "utils/strings.hpp"
 
+// Reads file directly into a string of its size, which saves intermediate
+// copies made by string streams.  Returns `false` if size of the file isn't
+// known in advance (e.g., it's not a regular file).
+static bool
+readSized(std::ifstream &ifile, std::string &contents)
+{
+    ifile.seekg(0, std::ios::end);
+    const std::streamoff size = (ifile ? std::streamoff(ifile.tellg()) : -1);
+    ifile.clear();
+    ifile.seekg(0, std::ios::beg);
+    if (size <= 0 || !ifile) {
+        ifile.clear();
+        return false;
+    }
+
+    contents.resize(size);
+    ifile.read(&contents[0], size);
+    contents.resize(ifile.gcount());
+    return true;
+}
+
 std::string
 readFile(const std::string &path)
 {
@@ -32,11 +55,16 @@ readFile(const std::string &path)
         throw std::runtime_error("Not a regular file: " + path);
     }
 
-    std::ifstream ifile(path);
+    std::ifstream ifile(path, std::ios::binary);
     if (!ifile) {
         throw std::runtime_error("Can't open file: " + path);
     }
 
+    std::string contents;
+    if (readSized(ifile, contents)) {
+        return normalizeEols(std::move(contents));
+    }
+
     std::ostringstream iss;
     iss << ifile.rdbuf();
     return normalizeEols(iss.str());
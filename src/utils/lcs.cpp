@@ -0,0 +1,157 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "utils/lcs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+// Longest common subsequence is computed with bit-parallel algorithm by
+// Hyyro, which processes 64 columns of dynamic programming table per operation.
+// Each row of the table is represented by a bit vector, whose zero bits mark
+// columns where length of LCS grows.  Rows are kept for recovering edit script.
+
+// Maximum number of 64-bit words in the table and masks of symbols, which
+// amounts to 8 MiB.
+static const std::size_t maxTableSize = 1024U*1024U;
+
+template <typename S, typename F>
+static bool diff(const S &a, const S &b, int alphabetSize, F symbol,
+                 std::vector<Edit> &script);
+
+bool
+diffSymbols(const std::vector<int> &a, const std::vector<int> &b,
+            int alphabetSize, std::vector<Edit> &script)
+{
+    return diff(a, b, alphabetSize, [](int x) { return x; }, script);
+}
+
+bool
+diffBytes(boost::string_ref a, boost::string_ref b, std::vector<Edit> &script)
+{
+    auto symbol = [](char c) { return static_cast<unsigned char>(c); };
+    return diff(a, b, 256, symbol, script);
+}
+
+// Computes edit script for two sequences, `symbol` maps their elements to
+// integers from the range [0, alphabetSize).
+template <typename S, typename F>
+static bool
+diff(const S &a, const S &b, int alphabetSize, F symbol,
+     std::vector<Edit> &script)
+{
+    using word = std::uint64_t;
+    const std::size_t bits = 64U;
+
+    script.clear();
+
+    // Common prefix and suffix don't need to go through the table.
+    const std::size_t n = a.size(), m = b.size();
+    std::size_t prefix = 0U;
+    while (prefix < n && prefix < m &&
+           symbol(a[prefix]) == symbol(b[prefix])) {
+        ++prefix;
+    }
+    std::size_t suffix = 0U;
+    while (suffix < n - prefix && suffix < m - prefix &&
+           symbol(a[n - 1U - suffix]) == symbol(b[m - 1U - suffix])) {
+        ++suffix;
+    }
+
+    // Table is built for reversed sequences, so that edit script can be
+    // recovered from the front.  Columns correspond to elements of `a`.
+    const std::size_t cols = n - prefix - suffix;
+    const std::size_t rows = m - prefix - suffix;
+
+    script.reserve(n + m - prefix - suffix);
+    script.assign(prefix, Edit::Common);
+    if (cols == 0U || rows == 0U) {
+        script.insert(script.end(), cols, Edit::Delete);
+        script.insert(script.end(), rows, Edit::Insert);
+        script.insert(script.end(), suffix, Edit::Common);
+        return true;
+    }
+
+    auto at = [&](const S &s, std::size_t i) { return symbol(s[prefix + i]); };
+
+    // Only symbols of `b` need masks of matching columns, all others are
+    // mapped onto id 0 which is never looked up.
+    std::vector<int> ids(alphabetSize, 0);
+    int nIds = 1;
+    for (std::size_t r = 0U; r < rows; ++r) {
+        int &id = ids[at(b, r)];
+        if (id == 0) {
+            id = nIds++;
+        }
+    }
+
+    const std::size_t words = (cols + bits - 1U)/bits;
+    if ((rows + 1U + nIds)*words > maxTableSize) {
+        script.clear();
+        return false;
+    }
+
+    // Masks of columns that match each of the symbols.
+    std::vector<word> matches(nIds*words);
+    for (std::size_t k = 0U; k < cols; ++k) {
+        const int id = ids[at(a, cols - 1U - k)];
+        matches[id*words + k/bits] |= word(1) << (k%bits);
+    }
+
+    std::vector<word> table((rows + 1U)*words, ~word(0));
+    for (std::size_t r = 0U; r < rows; ++r) {
+        const word *prev = &table[r*words];
+        const word *match = &matches[ids[at(b, rows - 1U - r)]*words];
+        word *row = &table[(r + 1U)*words];
+
+        word carry = 0U;
+        for (std::size_t w = 0U; w < words; ++w) {
+            const word v = prev[w];
+            const word u = v & match[w];
+            const word sum = v + u;
+            const word total = sum + carry;
+            carry = (sum < v) | (total < sum);
+            row[w] = total | (v & ~match[w]);
+        }
+    }
+
+    // Matching elements are always part of some LCS.  Otherwise, elements of
+    // `a` that don't add to LCS of the rest are deleted before elements of `b`
+    // are inserted.
+    std::size_t i = 0U, j = 0U;
+    while (i < cols && j < rows) {
+        const std::size_t k = cols - 1U - i;
+        if (at(a, i) == at(b, j)) {
+            script.push_back(Edit::Common);
+            ++i;
+            ++j;
+        } else if ((table[(rows - j)*words + k/bits] >> (k%bits)) & 1U) {
+            script.push_back(Edit::Delete);
+            ++i;
+        } else {
+            script.push_back(Edit::Insert);
+            ++j;
+        }
+    }
+    script.insert(script.end(), cols - i, Edit::Delete);
+    script.insert(script.end(), rows - j, Edit::Insert);
+    script.insert(script.end(), suffix, Edit::Common);
+    return true;
+}
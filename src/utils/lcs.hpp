@@ -0,0 +1,46 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__UTILS__LCS_HPP__
+#define ZOGRASCOPE__UTILS__LCS_HPP__
+
+#include <cstdint>
+
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+// Element of an edit script.
+enum class Edit : std::uint8_t
+{
+    Common, // Element is present in both sequences.
+    Delete, // Element is present only in the first sequence.
+    Insert  // Element is present only in the second sequence.
+};
+
+// Computes shortest edit script that turns sequence `a` into sequence `b`,
+// whose elements are symbols from the range [0, alphabetSize).  Returns `false`
+// leaving `script` empty if sequences are too large to be compared.
+bool diffSymbols(const std::vector<int> &a, const std::vector<int> &b,
+                 int alphabetSize, std::vector<Edit> &script);
+
+// Computes shortest edit script that turns bytes of `a` into bytes of `b`.
+// Returns `false` leaving `script` empty if strings are too large to be
+// compared.
+bool diffBytes(boost::string_ref a, boost::string_ref b,
+               std::vector<Edit> &script);
+
+#endif // ZOGRASCOPE__UTILS__LCS_HPP__
@@ -96,13 +96,22 @@ DiceString::getBigrams()
 std::string &&
 normalizeEols(std::string &&str)
 {
-    for (std::size_t pos = str.find('\r');
-         pos != std::string::npos;
-         pos = str.find('\r', pos)) {
-        if (pos < str.size() - 1 && str[pos + 1] == '\n') {
-            str.erase(pos, 1U);
+    std::size_t pos = str.find('\r');
+    if (pos == std::string::npos) {
+        return std::move(str);
+    }
+
+    // Compact the string in a single pass instead of erasing characters one by
+    // one, which is quadratic for files with DOS line endings.
+    std::size_t out = pos;
+    const std::size_t size = str.size();
+    for (; pos < size; ++pos) {
+        if (str[pos] == '\r' && pos + 1U < size && str[pos + 1U] == '\n') {
+            continue;
         }
+        str[out++] = str[pos];
     }
+    str.resize(out);
 
     return std::move(str);
 }
@@ -0,0 +1,148 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Catch/catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "utils/time.hpp"
+#include "EditScript.hpp"
+#include "compare.hpp"
+#include "tree.hpp"
+
+#include "tests.hpp"
+
+TEST_CASE("Edit script is written as JSON", "[edit-script]")
+{
+    const std::string oldContents = "int a;";
+    const std::string newContents = "int b;\n"
+                                    "long c;";
+    Tree oldTree = parseC(oldContents);
+    Tree newTree = parseC(newContents);
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    std::ostringstream oss;
+    writeEditScript(*oldTree.getRoot(), oldContents,
+                    *newTree.getRoot(), newContents,
+                    EditScriptFormat::Json, oss);
+
+    const std::string expected =
+        R"({"old":[)"
+        R"({"line":1,"col":1,"endLine":1,"endCol":4,"offset":0,"endOffset":3,)"
+        R"("state":"unchanged","moved":false,"relative":0},)"
+        R"({"line":1,"col":5,"endLine":1,"endCol":6,"offset":4,"endOffset":5,)"
+        R"("state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":6,"endLine":1,"endCol":7,"offset":5,"endOffset":6,)"
+        R"("state":"unchanged","moved":false,"relative":2}],)"
+        R"("new":[)"
+        R"({"line":1,"col":1,"endLine":1,"endCol":4,"offset":0,"endOffset":3,)"
+        R"("state":"unchanged","moved":false,"relative":0},)"
+        R"({"line":1,"col":5,"endLine":1,"endCol":6,"offset":4,"endOffset":5,)"
+        R"("state":"inserted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":6,"endLine":1,"endCol":7,"offset":5,"endOffset":6,)"
+        R"("state":"unchanged","moved":false,"relative":2},)"
+        R"({"line":2,"col":1,"endLine":2,"endCol":5,"offset":7,)"
+        R"("endOffset":11,"state":"inserted","moved":false,"relative":-1},)"
+        R"({"line":2,"col":6,"endLine":2,"endCol":7,"offset":12,)"
+        R"("endOffset":13,"state":"inserted","moved":false,"relative":-1},)"
+        R"({"line":2,"col":7,"endLine":2,"endCol":8,"offset":13,)"
+        R"("endOffset":14,"state":"inserted","moved":false,"relative":-1}]})"
+        "\n";
+    CHECK(oss.str() == expected);
+}
+
+TEST_CASE("Edit script is written in binary form", "[edit-script]")
+{
+    const std::string oldContents = "/* a\n"
+                                    "   b */";
+    Tree oldTree = parseC(oldContents);
+    Tree newTree = parseC("");
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    std::ostringstream oss;
+    writeEditScript(*oldTree.getRoot(), oldContents, *newTree.getRoot(), "",
+                    EditScriptFormat::Binary, oss);
+
+    const std::string expected("ZSES\1"
+                               "\1" "\1\1\1\10\0\14\1\0"
+                               "\0", 15);
+    CHECK(oss.str() == expected);
+}
+
+TEST_CASE("Edit script counts tabulations in columns", "[edit-script]")
+{
+    const std::string oldContents = "\tint a; /*\n"
+                                    "\t*/";
+    Tree oldTree = parseC(oldContents);
+    Tree newTree = parseC("");
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    std::ostringstream oss;
+    writeEditScript(*oldTree.getRoot(), oldContents, *newTree.getRoot(), "",
+                    EditScriptFormat::Json, oss);
+
+    const std::string expected =
+        R"({"old":[)"
+        R"({"line":1,"col":5,"endLine":1,"endCol":8,"offset":1,"endOffset":4,)"
+        R"("state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":9,"endLine":1,"endCol":10,"offset":5,"endOffset":6,)"
+        R"("state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":10,"endLine":1,"endCol":11,"offset":6,)"
+        R"("endOffset":7,"state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":12,"endLine":2,"endCol":7,"offset":8,)"
+        R"("endOffset":14,"state":"deleted","moved":false,"relative":-1}],)"
+        R"("new":[]})" "\n";
+    CHECK(oss.str() == expected);
+}
+
+TEST_CASE("Edit script handles old Mac line endings", "[edit-script]")
+{
+    const std::string oldContents = "int a;\r"
+                                    "long b;";
+    Tree oldTree = parseC(oldContents);
+    Tree newTree = parseC("");
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    std::ostringstream oss;
+    writeEditScript(*oldTree.getRoot(), oldContents, *newTree.getRoot(), "",
+                    EditScriptFormat::Json, oss);
+
+    const std::string expected =
+        R"({"old":[)"
+        R"({"line":1,"col":1,"endLine":1,"endCol":4,"offset":0,"endOffset":3,)"
+        R"("state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":5,"endLine":1,"endCol":6,"offset":4,"endOffset":5,)"
+        R"("state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":1,"col":6,"endLine":1,"endCol":7,"offset":5,"endOffset":6,)"
+        R"("state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":2,"col":1,"endLine":2,"endCol":5,"offset":7,)"
+        R"("endOffset":11,"state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":2,"col":6,"endLine":2,"endCol":7,"offset":12,)"
+        R"("endOffset":13,"state":"deleted","moved":false,"relative":-1},)"
+        R"({"line":2,"col":7,"endLine":2,"endCol":8,"offset":13,)"
+        R"("endOffset":14,"state":"deleted","moved":false,"relative":-1}],)"
+        R"("new":[]})" "\n";
+    CHECK(oss.str() == expected);
+}
@@ -16,12 +16,16 @@
 
 #include "Catch/catch.hpp"
 
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "utils/strings.hpp"
 #include "utils/time.hpp"
+#include "ColorScheme.hpp"
 #include "TermHighlighter.hpp"
 #include "compare.hpp"
+#include "decoration.hpp"
 #include "tree.hpp"
 
 #include "tests.hpp"
@@ -67,6 +71,26 @@ int f() { return 10; }
     CHECK(hi.print(20, 10) == "");
 }
 
+TEST_CASE("Lines are printed in a single pass", "[highlighter]")
+{
+    const std::string input = "/* line1\n"
+                              "\n"
+                              " * line3 */ int a;\n"
+                              "int f() {\n"
+                              "    return 10; }\n"
+                              "// line6";
+    Tree tree = parseC(input, true);
+
+    TermHighlighter lineByLine(tree);
+    std::vector<std::string> expected;
+    for (int i = 1; i <= 6; ++i) {
+        expected.push_back(lineByLine.print(i, 1));
+    }
+
+    CHECK(TermHighlighter(tree).printLines() == expected);
+    CHECK(expected[2] == " * line3 */ int a;");
+}
+
 TEST_CASE("Printing a subtree", "[highlighter]")
 {
     Tree tree = parseC(R"(
@@ -148,3 +172,93 @@ TEST_CASE("Non-transparent diffables have background filled", "[highlighter]")
     newHi.setTransparentDiffables(false);
     CHECK(newHi.print() == "// aa bb {+dd+}");
 }
+
+TEST_CASE("Spelling diffs can be shared", "[highlighter]")
+{
+    Tree oldTree = parseC("int oldVarName; // aa bb cc");
+    Tree newTree = parseC("int newVarName; // aa bb dd");
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    SpellingDiffCache spellingDiffs;
+
+    TermHighlighter oldHi(oldTree, true);
+    oldHi.setSpellingDiffCache(spellingDiffs);
+    CHECK(oldHi.print() == "int {-old-}{~VarName~}; // aa bb {-cc-}");
+    CHECK(spellingDiffs.size() == 2U);
+
+    TermHighlighter newHi(newTree, false);
+    newHi.setSpellingDiffCache(spellingDiffs);
+    CHECK(newHi.print() == "int {+new+}{~VarName~}; // aa bb {+dd+}");
+    CHECK(spellingDiffs.size() == 2U);
+}
+
+TEST_CASE("Trailing whitespace of diffed spelling is kept", "[highlighter]")
+{
+    Tree oldTree = parseC("int a; // aa bb cc  \n");
+    Tree newTree = parseC("int a; // aa bb dd  \n");
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    CHECK(TermHighlighter(oldTree, true).print() == "int a; // aa bb {-cc-}  ");
+    CHECK(TermHighlighter(newTree, false).print() == "int a; // aa bb {+dd+}  ");
+}
+
+TEST_CASE("Spelling isn't copied", "[highlighter]")
+{
+    Tree tree = parseC("int var;\n"
+                       "int other;");
+
+    int found = 0;
+    for (const ColorCane &cc : Highlighter(tree).printLines()) {
+        for (const ColorCanePiece &piece : cc) {
+            if (piece.node != nullptr && !piece.text.empty()) {
+                CHECK(piece.text.data() == piece.node->spelling.data());
+                ++found;
+            }
+        }
+    }
+    CHECK(found == 6);
+}
+
+TEST_CASE("Pieces of color cane are merged", "[highlighter]")
+{
+    ColorCane cc;
+    std::string expected;
+    for (int i = 0; i < 1000; ++i) {
+        cc.append('\n');
+        cc.append(' ', 4);
+        expected += "\n    ";
+    }
+
+    std::vector<ColorCanePiece> pieces(cc.begin(), cc.end());
+    REQUIRE(pieces.size() == 1U);
+    CHECK(pieces[0].text == expected);
+}
+
+TEST_CASE("Precompiled colors match decorations", "[highlighter]")
+{
+    Tree oldTree = parseC("int oldVarName; // aa bb cc");
+    Tree newTree = parseC("int newVarName; // aa bb dd");
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    for (bool enabled : { true, false }) {
+        if (enabled) {
+            decor::enableDecorations();
+        }
+
+        ColorScheme cs;
+        std::ostringstream oss;
+        for (const ColorCanePiece &piece : Highlighter(oldTree).print()) {
+            oss << (cs[piece.hi] << piece.text);
+        }
+        std::string printed = TermHighlighter(oldTree).print();
+
+        decor::disableDecorations();
+        CHECK(printed == oss.str());
+    }
+}
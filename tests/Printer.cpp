@@ -117,7 +117,7 @@ TEST_CASE("Inner diffing does not mess up column tracking", "[printer]")
         ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~!~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
         ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~!~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
          1                                |  1
-         2  format_str("{-...-}%s", str); {#~#}  2  format_str("%s{+%s+}"{+,+}{+ +}{+ell+}, str);
+         2  format_str("{-...-}%s", str); {#~#}  2  format_str("{+%s+}%s"{+,+}{+ +}{+ell+}, str);
     )");
 
     REQUIRE(printed == expected);
@@ -617,3 +617,24 @@ TEST_CASE("Diffing by characters", "[printer]")
 
     REQUIRE(printed == expected);
 }
+
+TEST_CASE("Markers of changes are counted in widths of columns", "[printer]")
+{
+    std::string printed = compareAndPrint(parseC(R"(
+        int variable = 1;
+        int longer_nam = 22;
+    )"), parseC(R"(
+        int variable = 2;
+        int longer_nam = 22;
+    )"));
+
+    std::string expected = normalizeText(R"(
+        ~~~~~~~~~~~~~~~~~~~~~~~~~~!~~~~~~~~~~~~~~~~~~~~~~~~~~
+        ~~~~~~~~~~~~~~~~~~~~~~~~~~!~~~~~~~~~~~~~~~~~~~~~~~~~~
+         1                        |  1
+         2  int variable = {#1#}; {#~#}  2  int variable = {#2#};
+         3  int longer_nam = 22;  |  3  int longer_nam = 22;
+    )");
+
+    REQUIRE(printed == expected);
+}
@@ -0,0 +1,169 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Catch/catch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "pmr/monolithic.hpp"
+
+#include "Language.hpp"
+#include "TreeBuilder.hpp"
+
+// Memory resource that counts allocations passed through it.
+class CountingResource : public cpp17::pmr::memory_resource
+{
+public:
+    std::size_t allocations = 0U;
+    std::size_t bytes = 0U;
+
+private:
+    virtual void * do_allocate(std::size_t bytes,
+                               std::size_t alignment) override
+    {
+        ++allocations;
+        this->bytes += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    virtual void do_deallocate(void *p, std::size_t bytes,
+                               std::size_t alignment) override
+    {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    virtual bool do_is_equal(const cpp17::pmr::memory_resource &other)
+        const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    cpp17::pmr::memory_resource *upstream =
+        cpp17::pmr::get_default_resource();
+};
+
+template <typename F>
+static float measure(F f);
+static Text makeText(std::uint32_t from);
+
+TEST_CASE("Lists of children are of exact size", "[treebuilder]")
+{
+    cpp17::pmr::monolithic mr;
+    TreeBuilder tb(mr);
+    const Location loc = {};
+
+    PNode *a = tb.addNode(makeText(1U), loc);
+
+    tb.addPostponed(makeText(2U), loc, SType{});
+    tb.addPostponed(makeText(3U), loc, SType{});
+    Text text = makeText(4U);
+    tb.markWithPostponed(text);
+    PNode *b = tb.addNode(text, loc);
+
+    PNode *node = tb.addNode({ a, b }, SType{});
+    REQUIRE(node->children.size() == 3U);
+    CHECK(node->children.capacity() == 3U);
+    CHECK(node->children[0] == a);
+    CHECK(node->children[1]->postponed);
+    CHECK(node->children[2]->value.from == 4U);
+
+    tb.setRoot(node);
+    tb.finish(false);
+    REQUIRE(tb.getRoot()->children.size() == 4U);
+    CHECK(tb.getRoot()->children[1]->value.from == 2U);
+    CHECK(tb.getRoot()->children[2]->value.from == 3U);
+}
+
+TEST_CASE("Building of parse tree", "[.bench][treebuilder]")
+{
+    std::string str;
+    for (int i = 0; i < 5000; ++i) {
+        const std::string n = std::to_string(i);
+        str += "/* function #" + n + " */\n"
+               "static int f" + n + "(int a, char *b[])\n"
+               "{\n"
+               "    if (a > " + n + " && b[a] != 0) {\n"
+               "        return g(a, b[a - 1], \"str\") + " + n + ";\n"
+               "    }\n"
+               "    return h(b, (a << 2) | 1);\n"
+               "}\n";
+    }
+
+    std::unique_ptr<Language> lang = Language::create("bench.c");
+
+    CountingResource counter;
+    cpp17::pmr::monolithic mr(&counter);
+
+    float ms = measure([&]() {
+        REQUIRE_FALSE(lang->parse(str, "<input>", false, mr).hasFailed());
+    });
+    std::cout << "parsing: " << ms << "ms, "
+              << mr.getAllocationCount() << " allocations, "
+              << counter.allocations << " blocks, "
+              << counter.bytes << " bytes\n";
+
+    // Same shape of reductions without lexing and parsing.
+    CountingResource builderCounter;
+    cpp17::pmr::monolithic builderMr(&builderCounter);
+    TreeBuilder tb(builderMr);
+    const Location loc = {};
+    ms = measure([&]() {
+        PNode *list = tb.addNode();
+        for (std::uint32_t i = 1U; i < 1000000U; ++i) {
+            if (i % 8U == 0U) {
+                tb.addPostponed(makeText(i), loc, SType{});
+            }
+            Text text = makeText(i);
+            tb.markWithPostponed(text);
+            PNode *leaf = tb.addNode(text, loc);
+            PNode *node = tb.addNode({ leaf, tb.addNode(makeText(i), loc) },
+                                     SType{});
+            tb.append(list, tb.addNode({ node }, SType{}));
+        }
+        tb.setRoot(list);
+        tb.finish(false);
+    });
+    std::cout << "building: " << ms << "ms, "
+              << builderMr.getAllocationCount() << " allocations, "
+              << builderCounter.allocations << " blocks, "
+              << builderCounter.bytes << " bytes\n";
+}
+
+// Measures how long it takes to run the function in milliseconds.
+template <typename F>
+static float
+measure(F f)
+{
+    using clock = std::chrono::steady_clock;
+    using msf = std::chrono::duration<float, std::milli>;
+
+    const clock::time_point start = clock::now();
+    f();
+    return msf(clock::now() - start).count();
+}
+
+static Text
+makeText(std::uint32_t from)
+{
+    return { from, 1U, 0U, 0U, 0 };
+}
@@ -16,6 +16,12 @@
 
 #include "Catch/catch.hpp"
 
+#include <string>
+#include <vector>
+
+#include "utils/time.hpp"
+#include "align.hpp"
+#include "compare.hpp"
 #include "tree.hpp"
 
 #include "tests.hpp"
@@ -437,3 +443,48 @@ TEST_CASE("Identical lines in different states don't match",
 
     REQUIRE(printed == expected);
 }
+
+TEST_CASE("Large inputs are aligned around unique lines", "[alignment]")
+{
+    auto makeSrc = [](bool updated) {
+        std::string src;
+        for (int i = 0; i < 100; ++i) {
+            if (updated && i == 50) {
+                src += "int inserted(void)\n"
+                       "{\n"
+                       "    return 0;\n"
+                       "}\n";
+            }
+
+            const std::string n = std::to_string(i);
+            src += "int f" + n + "(int a)\n"
+                   "{\n"
+                   "    return a*" + n + ";\n"
+                   "}\n";
+        }
+        return src;
+    };
+
+    Tree oldTree = parseC(makeSrc(false));
+    Tree newTree = parseC(makeSrc(true));
+
+    TimeReport tr;
+    compare(oldTree, newTree, tr, true, true);
+
+    std::vector<DiffLine> diff = makeDiff(DiffSource(*oldTree.getRoot()),
+                                          DiffSource(*newTree.getRoot()));
+
+    int left = 0, right = 0, common = 0;
+    for (const DiffLine &line : diff) {
+        switch (line.type) {
+            case Diff::Left:  ++left; break;
+            case Diff::Right: ++right; break;
+            case Diff::Fold:  common += line.data; break;
+            default:          ++common; break;
+        }
+    }
+
+    CHECK(left == 0);
+    CHECK(right == 4);
+    CHECK(common == 400);
+}
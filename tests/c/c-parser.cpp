@@ -22,10 +22,17 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
+#include <string>
+
+#include "pmr/monolithic.hpp"
 
 #include "c/C11SType.hpp"
+#include "c/c11-parser.hpp"
+#include "c/c11-split.hpp"
+#include "ParseCache.hpp"
 #include "TreeBuilder.hpp"
 #include "tree.hpp"
 #include "types.hpp"
@@ -33,6 +40,7 @@
 #include "tests.hpp"
 
 static int countNodes(const Node &root);
+static bool samePTrees(const PNode *a, const PNode *b);
 
 TEST_CASE("Empty input is OK", "[parser][extensions]")
 {
@@ -186,6 +194,21 @@ TEST_CASE("Postponed nodes between string literals are preserved",
           "constchar*str=\"\"/*str*/\"\";");
 }
 
+TEST_CASE("Long runs of postponed nodes keep their order",
+          "[parser][postponed]")
+{
+    std::string str = "int a = (((\n", expected = "inta=(((";
+    for (int i = 0; i < 100; ++i) {
+        str += "/*" + std::to_string(i) + "*/\n";
+        expected += "/*" + std::to_string(i) + "*/";
+    }
+    str += "1)));\n";
+    expected += "1)));";
+
+    Tree tree = parseC(str);
+    CHECK(printSubTree(*tree.getRoot(), true) == expected);
+}
+
 TEST_CASE("Escaping of newline isn't rejected", "[parser]")
 {
     const char *const str = R"(
@@ -453,6 +476,137 @@ TEST_CASE("EOL continuation is identified in C", "[parser]")
     CHECK(tree.getLanguage()->isEolContinuation(node));
 }
 
+TEST_CASE("C is split only at top-level declarations", "[parser][chunks]")
+{
+    std::string src = "int a; // comment\n"
+                      "struct s {\n"
+                      "    int a;\n"
+                      "};\n"
+                      "char *s = \"{;\\n\";\n"
+                      "#define X }\n"
+                      "void f(void) {\n"
+                      "    /* } */\n"
+                      "}\n"
+                      "int b;\n";
+
+    std::vector<C11SplitPoint> points = c11_split(src, src.size());
+    REQUIRE(points.size() == 3U);
+    CHECK(points[0].line == 5);
+    CHECK(points[1].line == 6);
+    CHECK(points[2].line == 10);
+    CHECK(src.compare(points[2].offset, 6U, "int b;") == 0);
+
+    CHECK(c11_split("int a;\nint b;\n", 1U).empty());
+    CHECK(c11_split("int f() {\nreturn 0;\n}\n", 10U).empty());
+}
+
+TEST_CASE("Chunked parsing of C yields the same tree", "[parser][chunks]")
+{
+    std::string src = "// leading comment\n"
+                      "#include <stdio.h>\n";
+    for (int i = 0; i < 20; ++i) {
+        const std::string n = std::to_string(i);
+        src += "/* function #" + n + " */\n"
+               "static int\n"
+               "f" + n + "(int a)\n"
+               "{\n"
+               "    return a + " + n + ";\n"
+               "}\n"
+               "\n"
+               "int var" + n + " = " + n + "; // var #" + n + "\n"
+               "struct s" + n + " { int a; };\n";
+    }
+    src += "// trailing comment\n";
+
+    cpp17::pmr::monolithic mrSerial, mrChunked;
+    TreeBuilder serial = c11_parse(src, "<input>", false, mrSerial);
+    TreeBuilder chunked = c11_parse_chunked(src, "<input>", 4U, mrChunked);
+
+    REQUIRE_FALSE(serial.hasFailed());
+    REQUIRE_FALSE(chunked.hasFailed());
+    CHECK(samePTrees(serial.getRoot(), chunked.getRoot()));
+}
+
+TEST_CASE("Chunked parsing of C reports errors once", "[parser][chunks]")
+{
+    std::string src;
+    for (int i = 0; i < 10; ++i) {
+        src += "int var" + std::to_string(i) + ";\n";
+    }
+    src += "int @;\n";
+
+    StreamCapture cerrCapture(std::cerr);
+    cpp17::pmr::monolithic mr;
+    CHECK(c11_parse_chunked(src, "<input>", 4U, mr).hasFailed());
+    CHECK(boost::starts_with(cerrCapture.get(), "<input>:11:5:"));
+}
+
+TEST_CASE("Reparsing of C reuses unchanged declarations", "[parser][chunks]")
+{
+    // Declarations are in the only child of the root that isn't postponed.
+    auto getDecls = [](TreeBuilder &tb) -> const CompactVector<PNode *> & {
+        const CompactVector<PNode *> &children = tb.getRoot()->children;
+        return (*std::find_if(children.cbegin(), children.cend(),
+                              [](PNode *node) { return !node->postponed; }))
+              ->children;
+    };
+
+    auto makeSrc = [](const std::string &edit) {
+        std::string src = "// leading comment\n";
+        for (int i = 0; i < 300; ++i) {
+            const std::string n = std::to_string(i);
+            src += "/* function #" + n + " */\n"
+                   "static int\n"
+                   "f" + n + "(int a)\n"
+                   "{\n"
+                   "    return a + " + (i == 150 ? edit : n) + ";\n"
+                   "}\n"
+                   "int var" + n + " = " + n + ";\n";
+        }
+        return src + "// trailing comment\n";
+    };
+
+    const std::string oldSrc = makeSrc("150");
+    const std::string newSrc = makeSrc("(a*2 - 1)");
+    ParseCache cache;
+
+    cpp17::pmr::monolithic mrOld, mrNew, mrOldSerial, mrNewSerial;
+    TreeBuilder oldTb = c11_reparse(oldSrc, "<input>", cache, mrOld);
+    REQUIRE_FALSE(oldTb.hasFailed());
+
+    TreeBuilder newTb = c11_reparse(newSrc, "<input>", cache, mrNew);
+    TreeBuilder serial = c11_parse(newSrc, "<input>", false, mrNewSerial);
+    REQUIRE_FALSE(newTb.hasFailed());
+    REQUIRE_FALSE(serial.hasFailed());
+    CHECK(samePTrees(serial.getRoot(), newTb.getRoot()));
+    CHECK(getDecls(newTb).size() == getDecls(serial).size());
+
+    // Reusing pieces doesn't affect result of the previous reparse.
+    TreeBuilder oldSerial = c11_parse(oldSrc, "<input>", false, mrOldSerial);
+    REQUIRE_FALSE(oldSerial.hasFailed());
+    CHECK(samePTrees(oldSerial.getRoot(), oldTb.getRoot()));
+}
+
+// Checks whether two parse trees are equal.
+static bool
+samePTrees(const PNode *a, const PNode *b)
+{
+    if (a->value.from != b->value.from || a->value.len != b->value.len ||
+        a->value.token != b->value.token || a->line != b->line ||
+        a->col != b->col || a->stype != b->stype ||
+        a->postponed != b->postponed ||
+        a->children.size() != b->children.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0U; i < a->children.size(); ++i) {
+        if (!samePTrees(a->children[i], b->children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static int
 countNodes(const Node &root)
 {
@@ -0,0 +1,110 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Catch/catch.hpp"
+
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pmr/monolithic.hpp"
+
+#include "utils/time.hpp"
+#include "Language.hpp"
+#include "Printer.hpp"
+#include "STree.hpp"
+#include "TreeBuilder.hpp"
+#include "compare.hpp"
+#include "tree.hpp"
+
+// This test is most useful when built with thread sanitizer enabled (see
+// `sanitize-thread` target of the Makefile).
+
+// Parses C source into a coarse tree without using Catch, which isn't
+// thread-safe.
+static Tree
+parseInThread(const std::string &str, cpp17::pmr::monolithic &mr)
+{
+    std::unique_ptr<Language> lang = Language::create("test-input.c");
+
+    TreeBuilder tb = lang->parse(str, "<input>", false, mr);
+    if (tb.hasFailed()) {
+        return Tree(&mr);
+    }
+
+    STree stree(std::move(tb), str, false, false, *lang, mr);
+    return Tree(std::move(lang), str, stree.getRoot(), &mr);
+}
+
+// Parses, compares and prints a pair of sources returning the output.
+static std::string
+diffInThread(const std::string &left, const std::string &right)
+{
+    cpp17::pmr::monolithic mrA, mrB;
+    Tree treeA = parseInThread(left, mrA);
+    Tree treeB = parseInThread(right, mrB);
+    if (treeA.isEmpty() || treeB.isEmpty()) {
+        return "<parsing error>";
+    }
+
+    TimeReport tr;
+    compare(treeA, treeB, tr, true, false);
+
+    std::ostringstream oss;
+    Printer printer(*treeA.getRoot(), *treeB.getRoot(), *treeA.getLanguage(),
+                    oss);
+    printer.print(tr);
+    return oss.str();
+}
+
+TEST_CASE("Multiple pairs of files can be diffed concurrently",
+          "[concurrency]")
+{
+    std::vector<std::pair<std::string, std::string>> pairs;
+    for (int i = 0; i < 8; ++i) {
+        const std::string n = std::to_string(i);
+        pairs.emplace_back(
+            "int f" + n + "(int a) { /* a very long comment here */\n"
+            "    return a + " + n + ";\n"
+            "}\n"
+            "void g() { f" + n + "(1); }\n",
+            "int f" + n + "(int a, int b) { /* a very long comment there */\n"
+            "    return a*b + " + n + ";\n"
+            "}\n"
+            "void h() { }\n"
+            "void g() { f" + n + "(1, 2); }\n"
+        );
+    }
+
+    std::vector<std::string> expected;
+    for (const auto &pair : pairs) {
+        expected.push_back(diffInThread(pair.first, pair.second));
+        REQUIRE(expected.back() != "<parsing error>");
+    }
+
+    std::vector<std::future<std::string>> futures;
+    for (const auto &pair : pairs) {
+        futures.push_back(std::async(std::launch::async, &diffInThread,
+                                     pair.first, pair.second));
+    }
+
+    for (std::size_t i = 0U; i < futures.size(); ++i) {
+        REQUIRE(futures[i].get() == expected[i]);
+    }
+}
@@ -0,0 +1,41 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Catch/catch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "integration.hpp"
+
+TEST_CASE("Commands can be started before their input is known",
+          "[integration]")
+{
+    PendingCommand first({ "cat" });
+    PendingCommand second({ "cat" });
+
+    // This would hang if `second` inherited input pipe of `first`.
+    CHECK(first.run("first\r\n") == "first\n");
+    CHECK(second.run("second") == "second");
+    CHECK_THROWS_AS(second.run("again"), std::logic_error);
+}
+
+TEST_CASE("Command that doesn't read its input is an error", "[integration]")
+{
+    const std::string input(1024*1024, 'x');
+    CHECK_THROWS_AS(readCommandOutput({ "false" }, input), std::runtime_error);
+    CHECK(readCommandOutput({ "cat" }, input) == input);
+}
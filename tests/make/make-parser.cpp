@@ -750,6 +750,16 @@ target:
                    "'define VERSION \"0.9.1-beta\"'") != nullptr);
 }
 
+TEST_CASE("Unterminated quote isn't a string", "[make][parser]")
+{
+    CHECK(makeIsParsed("'"));
+    CHECK(makeIsParsed("\"\n"));
+
+    Tree tree = parseMake("'a = \"b\nc = 'd'\n");
+    CHECK(findNode(tree, Type::StrConstants, "'d'") != nullptr);
+    CHECK(findNode(tree, Type::StrConstants, "\"b") == nullptr);
+}
+
 TEST_CASE("EOL continuation is identified in GNU Make", "[make][parser]")
 {
     Tree tree = parseMake(R"(
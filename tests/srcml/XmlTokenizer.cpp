@@ -0,0 +1,108 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Catch/catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "srcml/XmlTokenizer.hpp"
+
+namespace {
+
+// Records events as a string.
+class Recorder : public XmlHandler
+{
+public:
+    virtual void startElement(boost::string_ref name,
+                              const std::vector<XmlAttr> &attrs) override
+    {
+        events += '<' + name.to_string();
+        for (const XmlAttr &attr : attrs) {
+            events += ' ' + attr.name.to_string() + '=' +
+                      attr.value.to_string();
+        }
+        events += '>';
+    }
+
+    virtual void endElement() override
+    {
+        events += "</>";
+    }
+
+    virtual void text(boost::string_ref text) override
+    {
+        events += '[' + text.to_string() + ']';
+    }
+
+public:
+    std::string events;
+};
+
+}
+
+// Tokenizes input feeding it in pieces of specified size.
+static std::string
+tokenize(const std::string &xml, std::size_t pieceSize)
+{
+    Recorder recorder;
+    XmlTokenizer tokenizer(recorder);
+    for (std::size_t i = 0U; i < xml.size(); i += pieceSize) {
+        REQUIRE(tokenizer.feed(boost::string_ref(xml).substr(i, pieceSize)));
+    }
+    REQUIRE(tokenizer.finish());
+    return recorder.events;
+}
+
+TEST_CASE("XML is tokenized regardless of how it's split", "[srcml][xml]")
+{
+    const std::string xml =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<unit xmlns:cpp='http://www.srcML.org/srcML/cpp' language=\"C++\">"
+        "<!-- comment -->"
+        "<literal type=\"a>b\">&lt;&amp;&gt;&quot;&apos;&#65;&#x42;&bad;</literal>"
+        "  \n\t <cpp:empty/>\r\n text\r<![CDATA[&lt;]]></unit>\n";
+    const std::string expected =
+        "<unit xmlns:cpp=http://www.srcML.org/srcML/cpp language=C++>"
+        "<literal type=a>b>[<&>\"'AB&bad;]</>"
+        "<cpp:empty></>"
+        "[\n text\n][&lt;]"
+        "</>";
+
+    for (std::size_t pieceSize : { 1U, 2U, 3U, 7U, 1000U }) {
+        CHECK(tokenize(xml, pieceSize) == expected);
+    }
+}
+
+TEST_CASE("Malformed XML is reported", "[srcml][xml]")
+{
+    Recorder recorder;
+
+    XmlTokenizer unclosed(recorder);
+    CHECK(unclosed.feed("<unit><name>"));
+    CHECK_FALSE(unclosed.finish());
+    CHECK(unclosed.getError() != "");
+
+    XmlTokenizer unterminated(recorder);
+    CHECK(unterminated.feed("<unit"));
+    CHECK_FALSE(unterminated.finish());
+
+    XmlTokenizer unexpected(recorder);
+    CHECK_FALSE(unexpected.feed("</unit>"));
+    CHECK_FALSE(unexpected.finish());
+}
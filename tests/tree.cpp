@@ -16,7 +16,17 @@
 
 #include "Catch/catch.hpp"
 
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "pmr/monolithic.hpp"
+
 #include "c/C11SType.hpp"
+#include "Language.hpp"
+#include "STree.hpp"
+#include "TreeBuilder.hpp"
 #include "tree.hpp"
 
 #include "tests.hpp"
@@ -64,3 +74,38 @@ TEST_CASE("Coarse reduction links matched nodes", "[tree]")
     CHECK(findNode(oldTree, test, true) == nullptr);
     CHECK(findNode(newTree, test, true) == nullptr);
 }
+
+TEST_CASE("Coarse tree can be built without STree", "[tree][stree]")
+{
+    const std::string src = R"(
+        // comment
+        int main(int argc, char *argv[]) {
+            if (argc > 1) {
+                return (((argc)));
+            }
+            return 0;
+        }
+        struct s { int a; };
+    )";
+
+    auto dump = [&](bool withSTree) {
+        cpp17::pmr::monolithic mr;
+        std::unique_ptr<Language> lang = Language::create("test-input.c");
+        TreeBuilder tb = lang->parse(src, "<input>", false, mr);
+        REQUIRE_FALSE(tb.hasFailed());
+
+        Tree tree;
+        if (withSTree) {
+            STree stree(std::move(tb), src, false, false, *lang, mr);
+            tree = Tree(std::move(lang), src, stree.getRoot());
+        } else {
+            tree = Tree(std::move(lang), src, tb.getRoot(), &mr, true);
+        }
+
+        std::ostringstream oss;
+        dumpTree(oss, tree.getRoot(), tree.getLanguage());
+        return oss.str();
+    };
+
+    REQUIRE(dump(false) == dump(true));
+}
@@ -16,10 +16,181 @@
 
 #include "Catch/catch.hpp"
 
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pmr/monolithic.hpp"
+
+#include "utils/CompactVector.hpp"
+#include "utils/Interner.hpp"
+#include "utils/Pool.hpp"
+#include "utils/fs.hpp"
+#include "utils/lcs.hpp"
 #include "utils/strings.hpp"
 
+#include "tests.hpp"
+
 TEST_CASE("Different strings are recognized as different", "[utils][dice]")
 {
     DiceString diceB("abd");
     REQUIRE(DiceString("abc").compare(diceB) < 1.0f);
 }
+
+TEST_CASE("Line endings are normalized", "[utils][eols]")
+{
+    CHECK(normalizeEols("") == "");
+    CHECK(normalizeEols("a\nb") == "a\nb");
+    CHECK(normalizeEols("a\r\nb\r\n") == "a\nb\n");
+    CHECK(normalizeEols("a\rb\r") == "a\rb\r");
+    CHECK(normalizeEols("\r\r\n\n") == "\r\n\n");
+}
+
+TEST_CASE("Files are read with normalized line endings", "[utils][fs]")
+{
+    TempFile tmp("readfile");
+
+    {
+        std::ofstream ofile(tmp, std::ios::binary);
+        ofile << "line1\r\nline2\rline3\n";
+    }
+    CHECK(readFile(tmp) == "line1\nline2\rline3\n");
+
+    {
+        std::ofstream ofile(tmp, std::ios::binary | std::ios::trunc);
+    }
+    CHECK(readFile(tmp) == "");
+}
+
+TEST_CASE("Pool allocates objects in slabs", "[utils][pool]")
+{
+    cpp17::pmr::monolithic mr;
+    Pool<std::pair<int, int>> pool(&mr);
+
+    std::vector<std::pair<int, int> *> objects;
+    for (int i = 0; i < 10000; ++i) {
+        objects.push_back(pool.make(i, -i));
+    }
+    for (int i = 0; i < 10000; ++i) {
+        REQUIRE(objects[i]->first == i);
+        REQUIRE(objects[i]->second == -i);
+    }
+
+    CHECK(mr.getAllocationCount() < 10U);
+}
+
+TEST_CASE("Interner deduplicates strings", "[utils][interner]")
+{
+    cpp17::pmr::monolithic mr;
+    Interner interner(&mr);
+
+    std::string str = "some string";
+    boost::string_ref a = interner.intern(str);
+    str = "other string";
+    boost::string_ref b = interner.intern(str);
+    boost::string_ref c = interner.intern("some string");
+
+    CHECK(a == "some string");
+    CHECK(b == "other string");
+    CHECK(a.data() == c.data());
+    CHECK(a.data() != b.data());
+
+    const std::string large(10000, 'x');
+    boost::string_ref d = interner.intern(large);
+    CHECK(d == large);
+    CHECK(d.data() == interner.intern(large).data());
+}
+
+TEST_CASE("CompactVector is a vector", "[utils][compact-vector]")
+{
+    cpp17::pmr::monolithic mr;
+    CompactVector<int> v(&mr);
+    CHECK(sizeof(v) == 16U);
+    CHECK(v.empty());
+    CHECK(v.get_allocator().resource() == &mr);
+
+    for (int i = 0; i < 100; ++i) {
+        v.push_back(i);
+    }
+    REQUIRE(v.size() == 100U);
+    CHECK(v.get_allocator().resource() == &mr);
+
+    v.erase(v.cbegin() + 1, v.cend() - 1);
+    CHECK(std::vector<int>(v.cbegin(), v.cend()) == std::vector<int>{ 0, 99 });
+
+    const int extra[] = { 1, 2, 3 };
+    v.insert(v.cbegin() + 1, std::begin(extra), std::end(extra));
+    v.insert(v.cbegin(), -1);
+    CHECK(std::vector<int>(v.cbegin(), v.cend()) ==
+          std::vector<int>({ -1, 0, 1, 2, 3, 99 }));
+
+    CompactVector<int> moved(std::move(v), &mr);
+    CHECK(v.empty());
+    CHECK(moved.size() == 6U);
+    CHECK(moved.back() == 99);
+
+    moved.assign({ 7 });
+    CHECK(moved.size() == 1U);
+    CHECK(moved.front() == 7);
+}
+
+TEST_CASE("Edit script is computed", "[utils][lcs]")
+{
+    std::vector<Edit> script;
+
+    REQUIRE(diffSymbols({ 0, 1, 2, 3 }, { 0, 2, 3, 4 }, 5, script));
+    CHECK(script == std::vector<Edit>({ Edit::Common, Edit::Delete,
+                                        Edit::Common, Edit::Common,
+                                        Edit::Insert }));
+
+    // Inputs that don't fit into a single machine word.
+    std::string a, b;
+    for (int i = 0; i < 100; ++i) {
+        a += "ab";
+        b += "ba";
+    }
+    REQUIRE(diffBytes(a, b, script));
+    std::string left, right;
+    int common = 0;
+    std::size_t i = 0U, j = 0U;
+    for (Edit edit : script) {
+        switch (edit) {
+            case Edit::Common: left += a[i++]; right += b[j++]; ++common; break;
+            case Edit::Delete: left += a[i++]; break;
+            case Edit::Insert: right += b[j++]; break;
+        }
+    }
+    CHECK(left == a);
+    CHECK(right == b);
+    CHECK(common == 199);
+
+    const std::string large(10000, 'x');
+    CHECK_FALSE(diffBytes("y" + large, large + "y", script));
+    CHECK(script.empty());
+}
+
+TEST_CASE("Edit script of large alphabet is bounded", "[utils][lcs]")
+{
+    std::vector<Edit> script;
+
+    std::vector<int> a, b;
+    for (int i = 0; i < 100000; ++i) {
+        a.push_back(i);
+    }
+    b = { 0, 100000, 99999 };
+
+    REQUIRE(diffSymbols(a, b, 100001, script));
+    CHECK(script.size() == 100001U);
+    CHECK(script.front() == Edit::Common);
+    CHECK(script[99998] == Edit::Delete);
+    CHECK(script[99999] == Edit::Insert);
+    CHECK(script.back() == Edit::Common);
+
+    std::vector<int> cut(a.cbegin(), a.cbegin() + 10);
+    REQUIRE(diffSymbols(a, cut, 100000, script));
+    CHECK(script.size() == 100000U);
+    CHECK(script[9] == Edit::Common);
+    CHECK(script[10] == Edit::Delete);
+}
@@ -8,6 +8,12 @@
 #ifndef PMR__MONOLITHIC_HPP__
 #define PMR__MONOLITHIC_HPP__
 
+#if defined(__linux__)
+#  include <sys/mman.h>
+#endif
+
+#include <algorithm>
+
 #include "pmr_vector.hpp"
 #include "polymorphic_allocator.hpp"
 
@@ -17,17 +23,38 @@ using namespace std;
 
 namespace pmr {
 
+// Arena that hands out memory from a list of blocks and frees everything at
+// once.  Sizes of blocks grow geometrically starting at either default size or
+// at a size hint specified at construction (capped at the maximum block size).
+// release() allows reusing the arena for new set of allocations.
 class monolithic final : public memory_resource
 {
-    enum {
+    enum : size_t {
         blockSize = 64*1024,
+        maxBlockSize = 32*1024*1024,
+        hugePageSize = 2*1024*1024,
         alignment = alignof(std::max_align_t),
     };
 
 public:
     explicit monolithic(memory_resource *parent = get_default_resource());
+    // The hint specifies expected total size of allocations.
+    explicit monolithic(size_t sizeHint,
+                        memory_resource *parent = get_default_resource());
     virtual ~monolithic() override;
 
+public:
+    // Enables backing blocks that are at least as large as a huge page with
+    // anonymous memory mappings advised to use huge pages.  Does nothing on
+    // systems that don't support it.
+    void useHugePages(bool use);
+    // Frees all blocks except for the largest one, which is kept for reuse.
+    // Sizes of new blocks start growing from the initial size again.  All
+    // memory allocated from the arena becomes invalid.
+    void release();
+    // Retrieves number of allocation requests served by the arena so far.
+    size_t getAllocationCount() const { return allocationCount; }
+
 protected:
     virtual void * do_allocate(size_t bytes, size_t alignment) override;
     virtual void do_deallocate(void *p, size_t bytes,
@@ -40,13 +67,23 @@ private:
         size_t size;
         byte *start;
         byte *next;
+        bool mapped;
 
         byte * aligned(size_t alignment) const;
         byte * allocate(size_t n, size_t alignment);
     };
 
+    // Allocates a new block of at least specified size.
+    Block makeBlock(size_t size);
+    // Frees memory of the block.
+    void freeBlock(const Block &block);
+
     memory_resource *parent;
     vector<Block> blocks;
+    size_t initialSize;
+    size_t nextSize;
+    size_t allocationCount = 0U;
+    bool hugePages = false;
 };
 
 inline byte *
@@ -69,32 +106,109 @@ monolithic::Block::allocate(size_t n, size_t alignment)
 }
 
 inline
-monolithic::monolithic(memory_resource *parent) : parent(parent), blocks(parent)
+monolithic::monolithic(memory_resource *parent)
+    : parent(parent), blocks(parent), initialSize(blockSize),
+      nextSize(initialSize)
+{ }
+
+inline
+monolithic::monolithic(size_t sizeHint, memory_resource *parent)
+    : parent(parent), blocks(parent),
+      initialSize(min<size_t>(max<size_t>(blockSize, sizeHint), maxBlockSize)),
+      nextSize(initialSize)
 { }
 
 inline
 monolithic::~monolithic()
 {
     for (Block &alloc_rec : blocks) {
-        parent->deallocate(alloc_rec.start, alloc_rec.size, alignment);
+        freeBlock(alloc_rec);
+    }
+}
+
+inline void
+monolithic::useHugePages(bool use)
+{
+    hugePages = use;
+}
+
+inline void
+monolithic::release()
+{
+    nextSize = initialSize;
+
+    if (blocks.empty()) {
+        return;
+    }
+
+    auto largest = max_element(blocks.begin(), blocks.end(),
+                               [](const Block &a, const Block &b) {
+                                   return a.size < b.size;
+                               });
+    Block kept = *largest;
+    kept.next = kept.start;
+
+    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+        if (it != largest) {
+            freeBlock(*it);
+        }
     }
+
+    blocks.clear();
+    blocks.push_back(kept);
 }
 
 inline void *
 monolithic::do_allocate(size_t bytes, size_t align)
 {
+    ++allocationCount;
+
     void *ret;
     if (blocks.empty() || !(ret = blocks.back().allocate(bytes, align))) {
-        const size_t size = max(static_cast<std::size_t>(blockSize), bytes);
-
-        byte *r = static_cast<byte *>(parent->allocate(size, alignment));
-        blocks.push_back(Block{size, r, r});
+        blocks.push_back(makeBlock(max(nextSize, bytes)));
+        if (nextSize < maxBlockSize) {
+            nextSize = min<size_t>(nextSize*2U, maxBlockSize);
+        }
         ret = blocks.back().allocate(bytes, align);
     }
 
     return ret;
 }
 
+inline monolithic::Block
+monolithic::makeBlock(size_t size)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (hugePages && size >= hugePageSize) {
+        size = (size + hugePageSize - 1U)/hugePageSize*hugePageSize;
+        void *m = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (m != MAP_FAILED) {
+            // This is merely an advice, failure isn't a problem.
+            (void)madvise(m, size, MADV_HUGEPAGE);
+            byte *r = static_cast<byte *>(m);
+            return Block{size, r, r, true};
+        }
+    }
+#endif
+
+    byte *r = static_cast<byte *>(parent->allocate(size, alignment));
+    return Block{size, r, r, false};
+}
+
+inline void
+monolithic::freeBlock(const Block &block)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (block.mapped) {
+        munmap(block.start, block.size);
+        return;
+    }
+#endif
+
+    parent->deallocate(block.start, block.size, alignment);
+}
+
 inline void
 monolithic::do_deallocate(void */*p*/, size_t /*bytes*/, size_t /*alignment*/)
 {
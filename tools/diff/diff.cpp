@@ -19,7 +19,6 @@
 #include <boost/program_options/variables_map.hpp>
 
 #include <algorithm>
-#include <functional>
 #include <future>
 #include <iostream>
 #include <stdexcept>
@@ -29,7 +28,9 @@
 #include "pmr/monolithic.hpp"
 
 #include "tooling/common.hpp"
+#include "utils/fs.hpp"
 #include "utils/optional.hpp"
+#include "EditScript.hpp"
 #include "Printer.hpp"
 #include "compare.hpp"
 #include "decoration.hpp"
@@ -42,6 +43,7 @@ struct Args : CommonArgs
     bool gitDiff;       // Invoked by git and file was changed.
     bool gitRename;     // File was renamed and possibly changed too.
     bool gitRenameOnly; // File was renamed without changing it.
+    std::string format; // Format of the output.
 };
 
 static boost::program_options::options_description getLocalOpts();
@@ -82,7 +84,8 @@ main(int argc, char *argv[])
         result = EXIT_FAILURE;
     }
 
-    if (result != EXIT_SUCCESS && args.gitDiff) {
+    // Falling back to output of git makes sense only for humans.
+    if (result != EXIT_SUCCESS && args.gitDiff && args.format == "term") {
         if (args.pos[5] == std::string(40U, '0')) {
             execlp("git", "git", "diff", "--no-ext-diff", args.pos[2].c_str(),
                 "--", args.pos[0].c_str(), static_cast<char *>(nullptr));
@@ -101,7 +104,10 @@ getLocalOpts()
 {
     boost::program_options::options_description options;
     options.add_options()
-        ("no-refine", "do not refine coarse results");
+        ("no-refine", "do not refine coarse results")
+        ("format", boost::program_options::value<std::string>()
+                   ->default_value("term"),
+         "output format (term, json, binary)");
 
     return options;
 }
@@ -115,6 +121,11 @@ parseLocalArgs(const Environment &env)
     const boost::program_options::variables_map &varMap = env.getVarMap();
 
     args.noRefine = varMap.count("no-refine");
+    args.format = varMap["format"].as<std::string>();
+    if (args.format != "term" && args.format != "json" &&
+        args.format != "binary") {
+        throw std::invalid_argument("Unknown output format: " + args.format);
+    }
     args.gitDiff = args.pos.size() == 7U
                 || (args.pos.size() == 9U && args.pos[2] != args.pos[5]);
     args.gitRename = (args.pos.size() == 9U);
@@ -126,7 +137,19 @@ parseLocalArgs(const Environment &env)
 static int
 run(const Args &args, TimeReport &tr)
 {
+    const EditScriptFormat format = (args.format == "json")
+                                  ? EditScriptFormat::Json
+                                  : EditScriptFormat::Binary;
+
     if (args.gitRenameOnly) {
+        if (args.format != "term") {
+            // Contents is the same, hence there are no changes to report.
+            const Node empty;
+            writeEditScript(empty, std::string(), empty, std::string(), format,
+                            std::cout);
+            return EXIT_SUCCESS;
+        }
+
         std::cout << (decor::bold << "{ renamed without changes }\n")
                   << (decor::bold << "  old name: " << args.pos[0]) << '\n'
                   << (decor::bold << "  new name: " << args.pos[7]) << '\n';
@@ -136,20 +159,23 @@ run(const Args &args, TimeReport &tr)
     cpp17::pmr::monolithic mrA, mrB;
     Tree treeA(&mrA), treeB(&mrB);
 
-    using overload = optional_t<Tree> (*)(const std::string &,
-                                          const CommonArgs &, TimeReport &,
-                                          cpp17::pmr::memory_resource *);
-    overload func = &buildTreeFromFile;
-
     const std::string oldFile = (args.gitDiff ? args.pos[1] : args.pos[0]);
     const std::string newFile = (args.gitDiff ? args.pos[4] : args.pos[1]);
 
+    // Contents is kept around to compute offsets of tokens in edit scripts.
+    std::string oldContents, newContents;
+
     TimeReport nestedTr(tr);
     std::future<optional_t<Tree>> newTreeFuture =
-        std::async(std::launch::async, func, newFile,
-                   std::ref(args), std::ref(nestedTr), &mrB);
-
-    if (optional_t<Tree> &&tree = buildTreeFromFile(oldFile, args, tr, &mrA)) {
+        std::async(std::launch::async, [&]() {
+            newContents = readFile(newFile);
+            return buildTreeFromFile(newFile, newContents, args, nestedTr,
+                                     &mrB);
+        });
+
+    oldContents = readFile(oldFile);
+    if (optional_t<Tree> &&tree = buildTreeFromFile(oldFile, oldContents, args,
+                                                    tr, &mrA)) {
         treeA = *tree;
     } else {
         // Wait the other thread to finish to avoid data races.
@@ -175,6 +201,12 @@ run(const Args &args, TimeReport &tr)
 
     dumpTrees(args, treeA, treeB);
 
+    if (args.format != "term") {
+        writeEditScript(*treeA.getRoot(), oldContents,
+                        *treeB.getRoot(), newContents, format, std::cout);
+        return EXIT_SUCCESS;
+    }
+
     Printer printer(*treeA.getRoot(), *treeB.getRoot(), *treeA.getLanguage(),
                     std::cout);
     if (args.gitDiff) {
@@ -154,7 +154,8 @@ private:
 Q_DECLARE_METATYPE(TokenInfo *)
 
 ZSDiff::SideInfo
-ZSDiff::printTree(Tree &tree, CodeView *textEdit, bool original)
+ZSDiff::printTree(Tree &tree, CodeView *textEdit, bool original,
+                  SpellingDiffCache &spellingDiffs)
 {
     std::vector<StablePos> stopPositions;
 
@@ -162,6 +163,7 @@ ZSDiff::printTree(Tree &tree, CodeView *textEdit, bool original)
     Highlighter highlighter(tree, original);
     highlighter.setPrintBrackets(false);
     highlighter.setTransparentDiffables(false);
+    highlighter.setSpellingDiffCache(spellingDiffs);
 
     std::vector<ColorCane> hi = highlighter.print().splitIntoLines();
 
@@ -303,7 +305,8 @@ ZSDiff::loadDiff(const DiffEntry &diffEntry)
 
     if (optional_t<Tree> &&tree = buildTreeFromFile(diffEntry.original.path,
                                                     diffEntry.original.contents,
-                                                    {}, timeReport, &mr)) {
+                                                    {}, timeReport, &mr,
+                                                    &parseCache)) {
         oldTree = *tree;
     } else {
         ui->oldCode->setPlaceholderText("   PARSING HAS FAILED");
@@ -313,7 +316,8 @@ ZSDiff::loadDiff(const DiffEntry &diffEntry)
 
     if (optional_t<Tree> &&tree = buildTreeFromFile(diffEntry.updated.path,
                                                     diffEntry.updated.contents,
-                                                    {}, timeReport, &mr)) {
+                                                    {}, timeReport, &mr,
+                                                    &parseCache)) {
         newTree = *tree;
     } else {
         ui->oldCode->setPlaceholderText("   PARSING HAS FAILED");
@@ -326,11 +330,13 @@ ZSDiff::loadDiff(const DiffEntry &diffEntry)
     QTextDocument *oldDoc = ui->oldCode->document();
     QTextDocument *newDoc = ui->newCode->document();
 
+    SpellingDiffCache spellingDiffs;
     SideInfo leftSide = (timeReport.measure("left-print"),
-                         printTree(oldTree, ui->oldCode, true));
+                         printTree(oldTree, ui->oldCode, true, spellingDiffs));
     oldMap = std::move(leftSide.map);
     SideInfo rightSide = (timeReport.measure("right-print"),
-                          printTree(newTree, ui->newCode, false));
+                          printTree(newTree, ui->newCode, false,
+                                    spellingDiffs));
     newMap = std::move(rightSide.map);
 
     oldDoc->documentLayout()->registerHandler(blankLineAttr.getType(),
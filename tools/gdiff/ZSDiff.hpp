@@ -26,6 +26,7 @@
 #include <QMainWindow>
 
 #include "pmr/monolithic.hpp"
+#include "ParseCache.hpp"
 #include "tree.hpp"
 
 #include "BlankLineAttr.hpp"
@@ -41,6 +42,7 @@ class ZSDiff;
 class QPlainTextEdit;
 
 class Node;
+class SpellingDiffCache;
 class TimeReport;
 class SynHi;
 
@@ -76,7 +78,8 @@ public:
 private:
     void loadDiff(const DiffEntry &diffEntry);
     void updateTitle();
-    SideInfo printTree(Tree &tree, CodeView *textEdit, bool original);
+    SideInfo printTree(Tree &tree, CodeView *textEdit, bool original,
+                       SpellingDiffCache &spellingDiffs);
     void diffAndPrint(TimeReport &tr);
     void highlightMatch(QPlainTextEdit *textEdit);
     void syncOtherCursor(QPlainTextEdit *textEdit);
@@ -115,6 +118,9 @@ private:
     bool firstTimeFocus;
     bool folded;
     cpp17::pmr::monolithic mr;
+    // Pieces of previously parsed files that can be reused while loading
+    // other versions of them.
+    ParseCache parseCache;
     Tree oldTree;
     Tree newTree;
     std::unique_ptr<SynHi> oldSynHi;
@@ -19,9 +19,10 @@
 
 #include <algorithm>
 #include <functional>
-#include <memory>
 #include <iomanip>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "pmr/monolithic.hpp"
 #include "tooling/FunctionAnalyzer.hpp"
@@ -162,6 +163,8 @@ private:
 
     StatsAggregator funcSizes;
     StatsAggregator paramCounts;
+
+    cpp17::pmr::monolithic mr; // Arena reused for trees of all files.
 };
 
 }
@@ -292,7 +295,9 @@ FileProcessor::FileProcessor(const Args &args, TimeReport &tr)
 inline bool
 FileProcessor::operator()(const std::string &path)
 {
-    cpp17::pmr::monolithic mr;
+    // Tree of the previous file is gone by now, reuse memory it occupied.
+    mr.release();
+
     Tree tree(&mr);
 
     if (optional_t<Tree> &&t = buildTreeFromFile(path, args, tr, &mr)) {
@@ -323,9 +328,10 @@ FileProcessor::operator()(const std::string &path)
 
     const std::vector<LineContent> &map = lineAnalyzer.getMap();
 
-    std::unique_ptr<TermHighlighter> hi;
+    std::vector<std::string> annotated;
     if (args.annotate) {
-        hi.reset(new TermHighlighter(tree));
+        annotated = TermHighlighter(tree).printLines();
+        annotated.resize(map.size());
         std::cout << (pathHi << path) << '\n';
     }
 
@@ -357,12 +363,12 @@ FileProcessor::operator()(const std::string &path)
                 ++structural;
                 break;
         }
-        if (hi != nullptr) {
+        if (args.annotate) {
             std::cout << std::setw(lineColWidth)
                 << std::right << (lineNoHi << line << ' ') << ' '
                 << std::setw(12) << std::left
                 << (*dec << str) << " "
-                << hi->print(line, 1) << '\n';
+                << annotated[line - 1] << '\n';
         }
         ++line;
     }
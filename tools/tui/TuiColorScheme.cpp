@@ -0,0 +1,69 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TuiColorScheme.hpp"
+
+#include <cstddef>
+
+#include <string>
+#include <utility>
+
+#include "cursed/ColorTree.hpp"
+#include "cursed/utils.hpp"
+
+#include "ColorCane.hpp"
+#include "ColorScheme.hpp"
+
+static inline std::size_t
+operator+(ColorGroup cg)
+{
+    return static_cast<std::size_t>(cg);
+}
+
+TuiColorScheme::TuiColorScheme()
+{
+    for (std::size_t i = 0U; i < groups.size(); ++i) {
+        const ColorSpec &spec = getColorSpec(static_cast<ColorGroup>(i));
+        cursed::Format &format = groups[i];
+        if (spec.fg >= 0) {
+            format.setForeground(spec.fg);
+        }
+        if (spec.bg >= 0) {
+            format.setBackground(spec.bg);
+        }
+        format.setBold(spec.bold);
+        format.setReversed(spec.inverse);
+    }
+}
+
+const cursed::Format &
+TuiColorScheme::operator[](ColorGroup colorGroup) const
+{
+    return groups[+colorGroup];
+}
+
+cursed::ColorTree
+TuiColorScheme::colorize(const ColorCane &cc) const
+{
+    cursed::ColorTree line;
+    for (const ColorCanePiece &piece : cc) {
+        if (!piece.text.empty()) {
+            line = std::move(line)
+                 + groups[+piece.hi](cursed::toWide(piece.text.to_string()));
+        }
+    }
+    return line;
+}
@@ -0,0 +1,48 @@
+// Copyright (C) 2017 xaizek <xaizek@posteo.net>
+//
+// This file is part of zograscope.
+//
+// zograscope is free software: you can redistribute it and/or modify
+// it under the terms of version 3 of the GNU Affero General Public License as
+// published by the Free Software Foundation.
+//
+// zograscope is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with zograscope.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOGRASCOPE__TOOLS__TUI__TUICOLORSCHEME_HPP__
+#define ZOGRASCOPE__TOOLS__TUI__TUICOLORSCHEME_HPP__
+
+#include <array>
+#include <cstddef>
+
+#include "cursed/ColorTree.hpp"
+
+#include "colors.hpp"
+
+class ColorCane;
+
+// Maps color groups onto formats of the TUI library, which skips serializing
+// text into escape sequences that would have to be parsed back.  Colors come
+// from getColorSpec(), which ColorScheme uses as well.
+class TuiColorScheme
+{
+public:
+    TuiColorScheme();
+
+public:
+    const cursed::Format & operator[](ColorGroup colorGroup) const;
+
+    // Converts a single line of colored text into a tree of formats.
+    cursed::ColorTree colorize(const ColorCane &cc) const;
+
+private:
+    std::array<cursed::Format,
+               static_cast<std::size_t>(ColorGroup::ColorGroupCount)> groups;
+};
+
+#endif // ZOGRASCOPE__TOOLS__TUI__TUICOLORSCHEME_HPP__
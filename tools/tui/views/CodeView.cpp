@@ -16,17 +16,15 @@
 
 #include "CodeView.hpp"
 
-#include <sstream>
 #include <vector>
 
 #include "cursed/ListLike.hpp"
 #include "cursed/Text.hpp"
-#include "cursed/utils.hpp"
 
 #include "vle/Mode.hpp"
 
-#include "utils/strings.hpp"
-#include "TermHighlighter.hpp"
+#include "ColorCane.hpp"
+#include "Highlighter.hpp"
 #include "tree.hpp"
 
 #include "../ViewManager.hpp"
@@ -55,15 +53,11 @@ CodeView::buildMode()
 void
 CodeView::update()
 {
-    TermHighlighter hi(*context.node, *context.lang, true, context.node->line);
-
-    std::string printed = hi.print();
+    Highlighter hi(*context.node, *context.lang, true, context.node->line);
 
     std::vector<cursed::ColorTree> lines;
-    for (const boost::string_ref &sr : split(printed, '\n')) {
-        lines.push_back(
-            cursed::ColorTree::fromEscapeCodes(cursed::toWide(sr.to_string()))
-        );
+    for (const ColorCane &cc : hi.printLines()) {
+        lines.push_back(cs.colorize(cc));
     }
     text.setLines(std::move(lines));
 }
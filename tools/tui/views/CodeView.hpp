@@ -19,6 +19,7 @@
 
 #include "cursed/Text.hpp"
 
+#include "../TuiColorScheme.hpp"
 #include "../ViewManager.hpp"
 
 class CodeView : public View
@@ -32,6 +33,7 @@ public:
 
 private:
     cursed::Text text;
+    TuiColorScheme cs;
 };
 
 #endif // ZOGRASCOPE__TOOLS__TUI__VIEWS__CODEVIEW_HPP__